@@ -60,3 +60,8 @@ REM ================= CLIENT =================
 ECHO Building client.exe
 %cc% source/main.c source/client/fexp.c %compiler_flags% %defines% -DPLUGIN %backend% %include_flags% %linker_flags% -lbin/core -obin/client.exe
 REM ================= CLIENT END =================
+
+REM ================= PSYS BENCHMARK =================
+ECHO Building psys_bench.exe
+%cc% source/bench/psys_bench.c %compiler_flags% -O2 %defines% -DPLUGIN %backend% %include_flags% %linker_flags% -lbin/core -obin/psys_bench.exe
+REM ================= PSYS BENCHMARK END =================
@@ -0,0 +1,21 @@
+#version 330 core
+
+// One record per particle, the quad around it is expanded here
+layout (location = 0) in vec3 a_particle;
+layout (location = 1) in int  a_color;
+
+out vec4 v_color;
+
+uniform mat4 u_projection;
+uniform vec4 u_offset;
+
+const vec2 corners[6] = vec2[6](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0)
+);
+
+void main() {
+    vec2 pos = a_particle.xy + u_offset.xy + corners[gl_VertexID] * a_particle.z;
+    gl_Position = u_projection * vec4(pos, 0.0, 1.0);
+    v_color = vec4(a_color & 255, (a_color >> 8) & 255, (a_color >> 16) & 255, (a_color >> 24) & 255) / 255.0;
+}
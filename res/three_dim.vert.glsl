@@ -2,24 +2,37 @@
 
 layout (location = 0) in vec3 a_pos;
 layout (location = 1) in vec3 a_normal;
+layout (location = 2) in vec4 a_transform_row0;
+layout (location = 3) in vec4 a_transform_row1;
+layout (location = 4) in vec4 a_transform_row2;
+layout (location = 5) in vec4 a_transform_row3;
+layout (location = 6) in vec4 a_color;
+layout (location = 7) in int  a_id;
 
 out vec3 v_to_light;
 out vec3 v_normal;
 out vec3 v_to_cam;
+out vec4 v_color;
+flat out int v_id;
 
-uniform mat4 u_projection;
-uniform mat4 u_view;
-uniform mat4 u_transform;
+layout (std140, row_major) uniform Camera {
+    mat4 u_projection;
+    mat4 u_view;
+};
 
 vec3 light_pos = vec3(0.0, 10.0, 0.0);
 
 void main() {
-    vec4 world_pos = u_transform * vec4(a_pos, 1.0);
+    mat4 transform = transpose(mat4(a_transform_row0, a_transform_row1, a_transform_row2, a_transform_row3));
+    vec4 world_pos = transform * vec4(a_pos, 1.0);
     
     vec3 to_light = light_pos - a_pos;
-    v_normal = (u_transform * vec4(a_normal, 0.0)).xyz;
+    v_normal = (transform * vec4(a_normal, 0.0)).xyz;
     v_to_light = light_pos - world_pos.xyz;
     v_to_cam = (inverse(u_view) * vec4(0.0, 0.0, 0.0, 1.0)).xyz - world_pos.xyz;
     
+    v_color = a_color;
+    v_id = a_id;
+    
     gl_Position = u_projection * u_view * world_pos;
 }
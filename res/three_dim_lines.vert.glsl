@@ -5,8 +5,10 @@ layout (location = 1) in vec4 a_color;
 
 out vec4 v_color;
 
-uniform mat4 u_projection;
-uniform mat4 u_view;
+layout (std140, row_major) uniform Camera {
+    mat4 u_projection;
+    mat4 u_view;
+};
 uniform mat4 u_transform;
 
 void main() {
@@ -7,6 +7,7 @@
 #include "ds.h"
 #include "log.h"
 #include "mem.h"
+#include "rng.h"
 #include "str.h"
 #include "tctx.h"
 #include "utils.h"
@@ -0,0 +1,119 @@
+#include "rng.h"
+#include "mem.h"
+#include "os/os.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+#  define RNG_SIMD
+#endif
+
+// Spreads a seed out over the state, xoshiro can't start from all zeroes
+static u64 rng_splitmix64(u64* x) {
+	u64 z = (*x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+static u64 rng_rotl64(u64 x, u32 k) { return (x << k) | (x >> (64 - k)); }
+static u32 rng_rotl32(u32 x, u32 k) { return (x << k) | (x >> (32 - k)); }
+
+// The top 24 bits, exactly what an f32 mantissa can hold
+static f32 rng_unit_f32(u32 x) {
+	return (x >> 8) * (1.f / 16777216.f);
+}
+
+//~ Scalar
+
+void RNG_Seed(RNG_State* rng, u64 seed) {
+	for (u32 i = 0; i < 4; i++) rng->s[i] = rng_splitmix64(&seed);
+}
+
+u64 RNG_Next(RNG_State* rng) {
+	u64* s = rng->s;
+	u64 result = rng_rotl64(s[1] * 5, 7) * 9;
+	u64 t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rng_rotl64(s[3], 45);
+	return result;
+}
+
+f32 RNG_F32(RNG_State* rng) {
+	return rng_unit_f32((u32) (RNG_Next(rng) >> 32));
+}
+
+f32 RNG_F32PM(RNG_State* rng, f32 range) {
+	return (RNG_F32(rng) * 2.f - 1.f) * range;
+}
+
+//~ Batch
+
+void RNG_BatchSeed(RNG_Batch* rng, u64 seed) {
+	for (u32 lane = 0; lane < RNG_LANES; lane++) {
+		u64 a = rng_splitmix64(&seed);
+		u64 b = rng_splitmix64(&seed);
+		rng->s[0][lane] = (u32) a;
+		rng->s[1][lane] = (u32) (a >> 32);
+		rng->s[2][lane] = (u32) b;
+		rng->s[3][lane] = (u32) (b >> 32) | 1;
+	}
+}
+
+void RNG_BatchFillF32PM(RNG_Batch* rng, f32* out, u32 count, f32 base, f32 range) {
+	u32 i = 0;
+	f32 scale = 2.f * range / 16777216.f;
+	f32 offset = base - range;
+#if defined(RNG_SIMD)
+	__m128i s0 = _mm_loadu_si128((__m128i*) rng->s[0]);
+	__m128i s1 = _mm_loadu_si128((__m128i*) rng->s[1]);
+	__m128i s2 = _mm_loadu_si128((__m128i*) rng->s[2]);
+	__m128i s3 = _mm_loadu_si128((__m128i*) rng->s[3]);
+	__m128 vscale = _mm_set1_ps(scale);
+	__m128 voffset = _mm_set1_ps(offset);
+	
+	for (; i + RNG_LANES <= count; i += RNG_LANES) {
+		__m128i result = _mm_add_epi32(s0, s3);
+		__m128i t = _mm_slli_epi32(s1, 9);
+		s2 = _mm_xor_si128(s2, s0);
+		s3 = _mm_xor_si128(s3, s1);
+		s1 = _mm_xor_si128(s1, s2);
+		s0 = _mm_xor_si128(s0, s3);
+		s2 = _mm_xor_si128(s2, t);
+		s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+		
+		__m128 unit = _mm_cvtepi32_ps(_mm_srli_epi32(result, 8));
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(unit, vscale), voffset));
+	}
+	
+	_mm_storeu_si128((__m128i*) rng->s[0], s0);
+	_mm_storeu_si128((__m128i*) rng->s[1], s1);
+	_mm_storeu_si128((__m128i*) rng->s[2], s2);
+	_mm_storeu_si128((__m128i*) rng->s[3], s3);
+#endif
+	
+	// Same steps and math a lane at a time, builds without SSE2 produce the exact same values
+	for (u32 lane = 0; i < count; i++, lane = (lane + 1) % RNG_LANES) {
+		u32* s0 = &rng->s[0][lane]; u32* s1 = &rng->s[1][lane];
+		u32* s2 = &rng->s[2][lane]; u32* s3 = &rng->s[3][lane];
+		u32 result = *s0 + *s3;
+		u32 t = *s1 << 9;
+		*s2 ^= *s0;
+		*s3 ^= *s1;
+		*s1 ^= *s2;
+		*s0 ^= *s3;
+		*s2 ^= t;
+		*s3 = rng_rotl32(*s3, 11);
+		out[i] = (f32) (result >> 8) * scale + offset;
+	}
+}
+
+//~ Per Thread
+
+RNG_State* RNG_ThreadState(void) {
+	ThreadContext* ctx = (ThreadContext*) OS_ThreadContextGet();
+	return &ctx->rng;
+}
@@ -0,0 +1,34 @@
+/* date = October 19th 2026 8:30 pm */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include "defines.h"
+
+// xoshiro256** for single values, and RNG_LANES interleaved xoshiro128+ generators for filling arrays.
+// Neither touches global state, so the same seed always gives the same sequence
+#define RNG_LANES 4
+
+typedef struct RNG_State {
+	u64 s[4];
+} RNG_State;
+
+typedef struct RNG_Batch {
+	u32 s[4][RNG_LANES];
+} RNG_Batch;
+
+dll_plugin_api void RNG_Seed(RNG_State* rng, u64 seed);
+dll_plugin_api u64  RNG_Next(RNG_State* rng);
+// [0, 1)
+dll_plugin_api f32  RNG_F32(RNG_State* rng);
+// [-range, range)
+dll_plugin_api f32  RNG_F32PM(RNG_State* rng, f32 range);
+
+dll_plugin_api void RNG_BatchSeed(RNG_Batch* rng, u64 seed);
+// out[i] = base + [-range, range) for count values
+dll_plugin_api void RNG_BatchFillF32PM(RNG_Batch* rng, f32* out, u32 count, f32 base, f32 range);
+
+// The calling thread's own generator, seeded differently on every thread and every run
+dll_plugin_api RNG_State* RNG_ThreadState(void);
+
+#endif //RNG_H
@@ -4,6 +4,8 @@
 
 void tctx_init(ThreadContext* ctx) {
 	arena_init(&ctx->arena);
+	// The context's address tells apart threads started within the same microsecond
+	RNG_Seed(&ctx->rng, OS_TimeMicrosecondsNow() ^ (u64) ctx);
 	OS_ThreadContextSet(ctx);
 }
 
@@ -4,6 +4,7 @@
 #define TCTX_H
 
 #include "defines.h"
+#include "rng.h"
 
 #define M_SCRATCH_SIZE Kilobytes(32)
 
@@ -22,6 +23,7 @@ typedef struct ThreadContext {
 	M_Arena arena;
     u32 max_created;
     scratch_free_list_node* free_list;
+	RNG_State rng;
 } ThreadContext;
 
 dll_plugin_api void tctx_init(ThreadContext* ctx);
@@ -42,7 +42,20 @@ U_DateTime U_DateTimeFromDenseTime(U_DenseTime densetime) {
     return result;
 }
 
-//~ Time
+//~ Hashing
+
+// FNV-1a. Chain calls by passing the previous result as the seed
+u64 U_HashBytes(u64 seed, void* data, u64 size) {
+    u8* bytes = (u8*) data;
+    u64 hash = seed;
+    for (u64 i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+//~ Filepaths
 
 string U_FixFilepath(M_Arena* arena, string filepath) {
     M_Scratch scratch = scratch_get();
@@ -24,6 +24,12 @@ typedef struct U_DateTime {
 dll_plugin_api U_DenseTime U_DenseTimeFromDateTime(U_DateTime* datetime);
 dll_plugin_api U_DateTime  U_DateTimeFromDenseTime(U_DenseTime densetime);
 
+//~ Hashing
+
+#define U_HASH_SEED 14695981039346656037ull
+
+dll_plugin_api u64 U_HashBytes(u64 seed, void* data, u64 size);
+
 //~ Filepaths
 
 dll_plugin_api string U_FixFilepath(M_Arena* arena, string filepath);
@@ -357,6 +357,15 @@ rect rect_get_overlap(rect a, rect b) {
     return (rect) { min.x, min.y, max.x - min.x, max.y - min.y, };
 }
 
+// Rects with no area are treated as empty, so they don't grow the union
+rect rect_union(rect a, rect b) {
+    if (a.w <= 0 || a.h <= 0) return b;
+    if (b.w <= 0 || b.h <= 0) return a;
+    vec2 min = (vec2) { Min(a.x, b.x), Min(a.y, b.y) };
+    vec2 max = (vec2) { Max(a.x + a.w, b.x + b.w), Max(a.y + a.h, b.y + b.h) };
+    return (rect) { min.x, min.y, max.x - min.x, max.y - min.y, };
+}
+
 rect rect_uv_cull(rect quad, rect uv, rect cull_quad) {
     if (!rect_overlaps(quad, cull_quad) || rect_contained_by_rect(quad, cull_quad)) {
         return uv;
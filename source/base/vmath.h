@@ -126,6 +126,7 @@ dll_plugin_api b8   rect_contains_point(rect a, vec2 p);
 dll_plugin_api b8   rect_overlaps(rect a, rect b);
 dll_plugin_api b8   rect_contained_by_rect(rect a, rect b);
 dll_plugin_api rect rect_get_overlap(rect a, rect b);
+dll_plugin_api rect rect_union(rect a, rect b);
 dll_plugin_api rect rect_uv_cull(rect quad, rect uv, rect cull_quad);
 
 #endif //VMATH_H
@@ -0,0 +1,169 @@
+// Runs the psys simulation without a window, at a fixed step, for a range of particle counts.
+// The plugin is compiled straight in so the bench drives the same code the editor does.
+// Init needs a GL context for the instancing pipeline, so the frame is stepped here the way
+// Update and Render step it: cull, emit, then the integration on the job system.
+//
+// psys_bench [-steps N] [-dt seconds] [-threads 1,4,...] [-file emitter.psys] [count ...]
+//
+// Every count runs with the emitter (the defaults, or -file) and again with a built-in emitter that
+// turns on repulsion, one field of each type and both collider shapes, so those paths are checked too.
+// Prints ns per particle per step for every count and thread count, and exits with 1 if any run
+// ends in a state that isn't bit-for-bit the same as the first one for that count
+#include "plugins/psys_plug.c"
+#include "base/utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BenchMaxCounts 16
+#define BenchMaxThreads 8
+// Every configuration runs this many times, a rerun has to match as well as a different core count
+#define BenchRepeats 2
+// Repulsion makes the forces emitter much slower per particle, larger counts only run the plain one
+#define BenchForcesMaxCount 100000
+
+typedef struct psys_bench_run {
+	u64 hash;
+	u64 microseconds;
+	u64 particle_steps;
+} psys_bench_run;
+
+static u64 psys_bench_hash(psys_pool* pool) {
+	f32* streams[] = {
+		pool->pos_x, pool->pos_y, pool->vel_x, pool->vel_y, pool->acc_x, pool->acc_y,
+		pool->r, pool->g, pool->b, pool->a, pool->dr, pool->dg, pool->db, pool->da,
+		pool->size, pool->lifetime,
+	};
+	u64 hash = U_HashBytes(U_HASH_SEED, &pool->count, sizeof(u32));
+	for (u32 i = 0; i < ArrayCount(streams); i++)
+		hash = U_HashBytes(hash, streams[i], sizeof(f32) * pool->count);
+	return hash;
+}
+
+static psys_bench_run psys_bench_simulate(psys_emitter* emitter, u32 count, u32 steps, f32 dt) {
+	M_Arena bench_arena = {0};
+	arena_init(&bench_arena);
+	static psys_sim bench_sim;
+	psys_sim_init(&bench_sim, &bench_arena, count);
+	
+	// One burst fills the pool and the stream keeps it near full as they die off
+	psys_emitter e = *emitter;
+	e.burst_count = count;
+	e.burst_interval = 0.f;
+	e.speed = Max(e.blueprint.lifetime, dt) / count;
+	
+	psys_bench_run run = {0};
+	u64 start = OS_TimeMicrosecondsNow();
+	for (u32 i = 0; i < steps; i++) {
+		psys_cull_dead(&bench_sim.pool);
+		psys_emit(&bench_sim, &e, dt);
+		run.particle_steps += bench_sim.pool.count;
+		psys_sim_integrate(&bench_sim, &e, dt);
+		J_Wait(&bench_sim.group);
+	}
+	run.microseconds = OS_TimeMicrosecondsNow() - start;
+	run.hash = psys_bench_hash(&bench_sim.pool);
+	
+	arena_free(&bench_arena);
+	return run;
+}
+
+// Spread out so the neighbourhoods stay small, with every force and collider the step can run
+static void psys_bench_forces(psys_emitter* emitter) {
+	psys_emitter_defaults(emitter);
+	emitter->variance.pos = (vec2) { 300.f, 300.f };
+	emitter->variance.vel = (vec2) { 40.f, 40.f };
+	emitter->repulsion = 400.f;
+	emitter->repulsion_radius = 4.f;
+	emitter->fields[0] = (psys_force_field) { FieldType_Attractor, { 100.f, 0.f }, 80.f, 250.f };
+	emitter->fields[1] = (psys_force_field) { FieldType_Vortex, { -100.f, 50.f }, 60.f, 200.f };
+	emitter->fields[2] = (psys_force_field) { FieldType_Turbulence, { 0.f, 0.f }, 20.f, 40.f };
+	emitter->colliders[0] = (psys_collider) { ColliderType_Plane, { 0.f, 250.f }, { 0.f, -1.f }, 0.f, 0.5f };
+	emitter->colliders[1] = (psys_collider) { ColliderType_Circle, { 0.f, -80.f }, { 0.f, 0.f }, 60.f, 0.8f };
+}
+
+static u32 psys_bench_parse_list(char* arg, u32* out, u32 max) {
+	u32 n = 0;
+	while (*arg && n < max) {
+		out[n++] = (u32) strtoul(arg, &arg, 10);
+		if (*arg == ',') arg++;
+		else break;
+	}
+	return n;
+}
+
+int main(int argc, char** argv) {
+	OS_Init();
+	ThreadContext context = {0};
+	tctx_init(&context);
+	
+	u32 counts[BenchMaxCounts] = { 1000, 10000, 100000, 1000000 };
+	u32 count_count = 4;
+	b8 counts_given = false;
+	u32 threads[BenchMaxThreads] = { 1, OS_ProcessorCount() };
+	u32 thread_count = threads[1] > 1 ? 2 : 1;
+	u32 steps = 240;
+	f32 dt = 1.f / 60.f;
+	
+	psys_emitter emitter;
+	psys_emitter_defaults(&emitter);
+	psys_emitter forces;
+	psys_bench_forces(&forces);
+	psys_emitter* configs[] = { &emitter, &forces };
+	const char* config_names[] = { "emitter", "forces" };
+	
+	for (i32 i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-steps") && i + 1 < argc) {
+			steps = (u32) strtoul(argv[++i], nullptr, 10);
+		} else if (!strcmp(argv[i], "-dt") && i + 1 < argc) {
+			dt = (f32) atof(argv[++i]);
+		} else if (!strcmp(argv[i], "-threads") && i + 1 < argc) {
+			thread_count = psys_bench_parse_list(argv[++i], threads, BenchMaxThreads);
+		} else if (!strcmp(argv[i], "-file") && i + 1 < argc) {
+			char* file = argv[++i];
+			M_Scratch scratch = scratch_get();
+			string path = str_copy(&scratch.arena, (string) { (u8*) file, strlen(file) });
+			string block = psys_file_emitter(OS_FileRead(&scratch.arena, path), 0);
+			if (block.str) psys_emitter_read(&emitter, block);
+			else printf("%s isn't a particle system file this version can read, using defaults\n", file);
+			scratch_return(&scratch);
+		} else {
+			if (!counts_given) count_count = 0;
+			counts_given = true;
+			if (count_count < BenchMaxCounts) counts[count_count++] = (u32) strtoul(argv[i], nullptr, 10);
+		}
+	}
+	
+	b8 deterministic = true;
+	printf("%u steps of %.4fs\n", steps, dt);
+	printf("%8s %10s %8s %14s %18s\n", "emitter", "particles", "threads", "ns/particle", "state");
+	for (u32 k = 0; k < ArrayCount(configs); k++) {
+		for (u32 c = 0; c < count_count; c++) {
+			u32 count = counts[c];
+			if (!count) continue;
+			if (configs[k] == &forces && count > BenchForcesMaxCount) continue;
+			u64 expected = 0;
+			
+			for (u32 t = 0; t < thread_count; t++) {
+				// One thread means no workers at all, dispatches run inline on this one
+				if (threads[t] > 1) J_Init(threads[t] - 1);
+				
+				for (u32 r = 0; r < BenchRepeats; r++) {
+					psys_bench_run run = psys_bench_simulate(configs[k], count, steps, dt);
+					if (!expected) expected = run.hash;
+					b8 match = run.hash == expected;
+					deterministic &= match;
+					
+					f64 ns = run.particle_steps ? run.microseconds * 1000.0 / run.particle_steps : 0.0;
+					printf("%8s %10u %8u %14.3f   %016llx%s\n", config_names[k], count, Max(threads[t], 1), ns,
+						   run.hash, match ? "" : " MISMATCH");
+				}
+				
+				J_Shutdown();
+			}
+		}
+	}
+	
+	if (!deterministic) printf("Runs diverged, the simulation isn't deterministic anymore\n");
+	tctx_free(&context);
+	return deterministic ? 0 : 1;
+}
@@ -1,4 +1,6 @@
 #include "fexp.h"
+#include "core/frame.h"
+#include <math.h>
 
 b8 check_plugin(string name);
 
@@ -11,15 +13,31 @@ void fexp_init(fexp_context* ctx) {
     ctx->current_query_idx = 0;
 }
 
+void fexp_free(fexp_context* ctx) {
+	R2D_DrawListFree(&ctx->list);
+	arena_free(&ctx->arena);
+}
+
+static b8 fexp_rect_settled(rect a, rect b) {
+	return fabsf(a.x - b.x) < 0.5f && fabsf(a.y - b.y) < 0.5f && fabsf(a.w - b.w) < 0.5f && fabsf(a.h - b.h) < 0.5f;
+}
+
 void fexp_update(fexp_context* ctx, f32 dt) {
     //- Updating 
 	M_Scratch scratch = scratch_get();
     
 	ctx->latest_count = 0;
+	ctx->listing_hash = U_HASH_SEED;
     animate_f32exp(&ctx->selection_rect.x, ctx->target_selection_rect.x, 40.f, dt);
     animate_f32exp(&ctx->selection_rect.y, ctx->target_selection_rect.y, 40.f, dt);
     animate_f32exp(&ctx->selection_rect.w, ctx->target_selection_rect.w, 40.f, dt);
     animate_f32exp(&ctx->selection_rect.h, ctx->target_selection_rect.h, 40.f, dt);
+	// Snap once it's visually there so the explorer can go idle
+	if (fexp_rect_settled(ctx->selection_rect, ctx->target_selection_rect)) {
+		ctx->selection_rect = ctx->target_selection_rect;
+	} else {
+		F_RequestRedraw();
+	}
     
     string fixed = str_cat(&scratch.arena, ctx->current_filepath, str_lit("/*"));
     string fixed_query = { .str = ctx->current_query.str, .size = ctx->current_query_idx };
@@ -29,6 +47,7 @@ void fexp_update(fexp_context* ctx, f32 dt) {
     while (OS_FileIterNext(&scratch.arena, &iter, &name, &props)) {
         if (str_find_first(name, fixed_query, 0) != name.size) {
             ctx->latest_count++;
+			ctx->listing_hash = U_HashBytes(ctx->listing_hash, name.str, name.size);
         }
     }
     OS_FileIterEnd(&iter);
@@ -201,27 +220,37 @@ void fexp_render(fexp_context* ctx, R2D_Renderer* cb) {
 		fixed_full_query = str_cat(&scratch.arena, str_lit("Enter Drive: "), fixed_full_query);
 	}
 	
-	f32 y = ctx->font->font_size * 2.5;
-	R2D_DrawStringC(cb, ctx->font, (vec2) { 16, ctx->font->font_size * 1.15f }, fixed_full_query, (vec4) { .3f, .4f, .8f, 1.f });
-	R2D_DrawQuadC(cb, (rect) { 0, ctx->font->font_size * 1.55f, cb->cull_quad.w, 1.f }, (vec4) { .8f, .4, .3f, 2.f }, 1.f);
+	// Only re-record when something that shows up on screen has changed
+	u64 hash = U_HashBytes(U_HASH_SEED, fixed_full_query.str, fixed_full_query.size);
+	hash = U_HashBytes(hash, &ctx->mode, sizeof(ctx->mode));
+	hash = U_HashBytes(hash, &ctx->selection_rect, sizeof(rect));
+	hash = U_HashBytes(hash, &ctx->listing_hash, sizeof(u64));
+	hash = U_HashBytes(hash, &cb->cull_quad, sizeof(rect));
 	
-	if (ctx->mode == InputMode_Regular) {
-		OS_FileIterator iter = OS_FileIterInitPattern(fixed);
-		u32 idx = 0;
-		string name; OS_FileProperties props;
-		
-		R2D_DrawQuadC(cb, ctx->selection_rect, (vec4) { .3f, .3f, .3f, 1.f }, 4.f);
+	if (R2D_DrawListBegin(cb, &ctx->list, hash)) {
+		f32 y = ctx->font->font_size * 2.5;
+		R2D_DrawStringC(cb, ctx->font, (vec2) { 16, ctx->font->font_size * 1.15f }, fixed_full_query, (vec4) { .3f, .4f, .8f, 1.f });
+		R2D_DrawQuadC(cb, (rect) { 0, ctx->font->font_size * 1.55f, cb->cull_quad.w, 1.f }, (vec4) { .8f, .4, .3f, 2.f }, 1.f);
 		
-		while (OS_FileIterNext(&scratch.arena, &iter, &name, &props)) {
-			if (str_find_first(name, fixed_query, 0) != name.size) {
-				R2D_DrawString(cb, ctx->font, (vec2) { 14, y }, name);
-				y += ctx->font->font_size + 2;
-				idx++;
+		if (ctx->mode == InputMode_Regular) {
+			OS_FileIterator iter = OS_FileIterInitPattern(fixed);
+			u32 idx = 0;
+			string name; OS_FileProperties props;
+			
+			R2D_DrawQuadC(cb, ctx->selection_rect, (vec4) { .3f, .3f, .3f, 1.f }, 4.f);
+			
+			while (OS_FileIterNext(&scratch.arena, &iter, &name, &props)) {
+				if (str_find_first(name, fixed_query, 0) != name.size) {
+					R2D_DrawString(cb, ctx->font, (vec2) { 14, y }, name);
+					y += ctx->font->font_size + 2;
+					idx++;
+				}
 			}
+			
+			OS_FileIterEnd(&iter);
 		}
-		
-		OS_FileIterEnd(&iter);
 	}
+	R2D_DrawListEnd(cb, &ctx->list);
 	
 	scratch_return(&scratch);
 }
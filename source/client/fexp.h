@@ -26,6 +26,8 @@ typedef struct fexp_context {
     rect selection_rect;
     rect target_selection_rect;
     string current_filepath;
+	u64 listing_hash;
+	R2D_DrawList list;
 	
 	InputMode mode;
     string current_query;
@@ -38,6 +40,7 @@ typedef struct fexp_context {
 } fexp_context;
 
 void fexp_init(fexp_context* ctx);
+void fexp_free(fexp_context* ctx);
 void fexp_update(fexp_context* ctx, f32 dt);
 void fexp_input_key(fexp_context* ctx, OS_Window* window, u8 key, i32 action);
 void fexp_render(fexp_context* ctx, R2D_Renderer* cb);
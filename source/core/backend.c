@@ -1,4 +1,5 @@
 #include "backend.h"
+#include "resources.h"
 
 #if defined(BACKEND_GL46)
 #  if defined(PLATFORM_WIN)
@@ -14,6 +14,8 @@ dll_plugin_api void B_BackendInitShared(OS_Window* window, OS_Window* share);
 
 dll_plugin_api void B_BackendSelectRenderWindow(OS_Window* window);
 dll_plugin_api void B_BackendSwapchainNext(OS_Window* window);
+// True if the back buffer still holds the last frame after a swap, so only damage needs redrawing
+dll_plugin_api b8   B_BackendSwapPreservesContents(OS_Window* window);
 dll_plugin_api void B_BackendFree(OS_Window* window);
 
 #endif //BACKEND_H
@@ -0,0 +1,51 @@
+#include "frame.h"
+#include "os/os.h"
+
+static u64 _frame_budget = 0;
+static u64 _frame_start = 0;
+static u64 _last_frame_start = 0;
+static b8  _redraw_requested = false;
+static b8  _continuous = false;
+static b8  _idled = false;
+static OS_Timer _frame_timer = {0};
+
+void F_Init(u32 target_fps) {
+	_frame_budget = target_fps ? 1000000 / target_fps : 0;
+	_frame_start = OS_TimeMicrosecondsNow();
+	_last_frame_start = _frame_start;
+	_redraw_requested = true;
+	if (!_frame_timer.v[0]) _frame_timer = OS_TimerCreate();
+}
+
+void F_WaitForFrame(void) {
+	if (_continuous || _redraw_requested) return;
+	// Input cuts the wait short, the time since the last frame is real then and dt keeps it
+	_idled = !OS_WaitForEvents(F_IDLE_TIMEOUT_MS);
+}
+
+f32 F_FrameBegin(void) {
+	_frame_start = OS_TimeMicrosecondsNow();
+	f32 dt = (_frame_start - _last_frame_start) / 1e6;
+	_last_frame_start = _frame_start;
+	// Nothing was animating while asleep, so the first frame back counts as a single frame
+	if (_idled) dt = _frame_budget ? _frame_budget / 1e6 : 1.f / 60.f;
+	_idled = false;
+	// Requests are one-shot, whoever still needs a frame asks again this frame
+	_redraw_requested = false;
+	return Min(dt, F_MAX_DT);
+}
+
+void F_FrameEnd(void) {
+	u64 elapsed = OS_TimeMicrosecondsNow() - _frame_start;
+	if (elapsed < _frame_budget) {
+		OS_TimerSleepMicroseconds(&_frame_timer, _frame_budget - elapsed);
+	}
+}
+
+void F_RequestRedraw(void) {
+	_redraw_requested = true;
+}
+
+void F_RequestContinuous(b8 continuous) {
+	_continuous = continuous;
+}
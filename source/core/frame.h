@@ -0,0 +1,26 @@
+/* date = October 19th 2026 10:12 am */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include "defines.h"
+#include "base/base.h"
+
+#include "os/window.h"
+
+// How long an idle loop blocks before waking up anyway (to pick up filesystem changes etc.)
+#define F_IDLE_TIMEOUT_MS 250
+// dt is clamped so a long hitch doesn't blow up animations
+#define F_MAX_DT (1.f / 15.f)
+
+//~ Scheduling
+dll_plugin_api void F_Init(u32 target_fps);
+dll_plugin_api void F_WaitForFrame(void);
+dll_plugin_api f32  F_FrameBegin(void);
+dll_plugin_api void F_FrameEnd(void);
+
+//~ Requests
+dll_plugin_api void F_RequestRedraw(void);
+dll_plugin_api void F_RequestContinuous(b8 continuous);
+
+#endif //FRAME_H
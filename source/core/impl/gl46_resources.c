@@ -2,6 +2,10 @@
 #include <stb/stb_image.h>
 
 #include "gl_functions.h"
+#include "gl_state.h"
+#include "gl_program_cache.h"
+#include "gl_timer.h"
+#include "resource_registry.h"
 
 HashTable_Prototype(uniform, string, i32);
 b8 str_is_null(string k)  { return k.str == 0 && k.size == 0; }
@@ -60,6 +64,13 @@ typedef struct R_GL46Framebuffer {
 	u32 handle;
 } R_GL46Framebuffer;
 
+typedef struct R_GL46Readback {
+	u32 pbo;
+	u32 bytes;
+	u64 size;
+	GLsync fence;
+} R_GL46Readback;
+
 
 //~ Elpers
 
@@ -181,6 +192,20 @@ static u32 get_texture_datatype_of(R_TextureFormat format) {
 	return 0;
 }
 
+static u32 get_texture_pixel_size_of(R_TextureFormat format) {
+	AssertTrue(7 == TextureFormat_MAX,
+			   "Non Exhaustive switch statement: get_texture_pixel_size_of in gl46 backend");
+	switch (format) {
+		case TextureFormat_RInteger: return 4;
+		case TextureFormat_R: return 1;
+		case TextureFormat_RG: return 2;
+		case TextureFormat_RGB: return 3;
+		case TextureFormat_RGBA: return 4;
+		case TextureFormat_DepthStencil: return 4;
+	}
+	return 0;
+}
+
 static u32 get_texture_internal_format_type_of(R_TextureFormat format) {
     AssertTrue(7 == TextureFormat_MAX,
 			   "Non Exhaustive switch statement: get_texture_internal_format_type_of in gl46 backend");
@@ -215,6 +240,7 @@ void R_BufferAlloc(R_Buffer* _buf, R_BufferFlags flags) {
 	R_GL46Buffer* buf = (R_GL46Buffer*) _buf;
 	buf->flags = flags;
 	glCreateBuffers(1, &buf->handle);
+	R_RegistryAdd(ResourceType_Buffer, buf->handle, 0);
 }
 
 void R_BufferData(R_Buffer* _buf, u64 size, void* data) {
@@ -222,6 +248,7 @@ void R_BufferData(R_Buffer* _buf, u64 size, void* data) {
 	u32 flags = 0;
 	flags |= buf->flags & BufferFlag_Dynamic ? GL_DYNAMIC_STORAGE_BIT : 0;
 	glNamedBufferStorage(buf->handle, size, data, flags);
+	R_RegistryResize(ResourceType_Buffer, buf->handle, size);
 }
 
 void R_BufferUpdate(R_Buffer* _buf, u64 offset, u64 size, void* data) {
@@ -231,9 +258,16 @@ void R_BufferUpdate(R_Buffer* _buf, u64 offset, u64 size, void* data) {
 
 void R_BufferFree(R_Buffer* _buf) {
 	R_GL46Buffer* buf = (R_GL46Buffer*) _buf;
+	R_GLStateForget(&_gl_state.array_buffer, buf->handle);
+	R_RegistryRemove(ResourceType_Buffer, buf->handle);
 	glDeleteBuffers(1, &buf->handle);
 }
 
+void R_BufferBindUniform(R_Buffer* _buf, u32 binding) {
+	R_GL46Buffer* buf = (R_GL46Buffer*) _buf;
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, buf->handle);
+}
+
 //~ Shaders
 
 void R_ShaderAlloc(R_Shader* _shader, string data, R_ShaderType type) {
@@ -277,10 +311,13 @@ void R_ShaderPackAlloc(R_ShaderPack* _pack, R_Shader* shaders, u32 shader_count)
 	uniform_hash_table_init(&pack->uniforms);
 	
 	pack->handle = glCreateProgram();
+	R_RegistryAdd(ResourceType_ShaderPack, pack->handle, 0);
 	for (u32 i = 0; i < shader_count; i++) {
 		R_GL46Shader* shader = (R_GL46Shader*) &shaders[i];
 		glAttachShader(pack->handle, shader->handle);
 	}
+	if (R_GLProgramBinarySupported())
+		glProgramParameteri(pack->handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(pack->handle);
 	
 	i32 ret = 0;
@@ -303,94 +340,138 @@ void R_ShaderPackAlloc(R_ShaderPack* _pack, R_Shader* shaders, u32 shader_count)
 }
 
 void R_ShaderPackAllocLoad(R_ShaderPack* _pack, string fp_prefix) {
+	R_GL46ShaderPack* pack = (R_GL46ShaderPack*) _pack;
 	M_Scratch scratch = scratch_get();
 	
 	string vsfp = str_cat(&scratch.arena, fp_prefix, str_lit(".vert.glsl"));
 	string fsfp = str_cat(&scratch.arena, fp_prefix, str_lit(".frag.glsl"));
 	string gsfp = str_cat(&scratch.arena, fp_prefix, str_lit(".geom.glsl"));
 	
-	R_Shader* shader_buffer = arena_alloc(&scratch.arena, sizeof(R_Shader) * 3);
-	u32 shader_count = 0;
+	string sources[ShaderType_MAX] = {0};
 	
 	if (!OS_FileExists(vsfp))
 		LogError("The Vertex Shader File '%s.vert.glsl' doesn't exist", fp_prefix.str);
 	else Log("Loading Vertex Shader '%s.vert.glsl'", fp_prefix.str);
-	R_ShaderAllocLoad(&shader_buffer[shader_count++], vsfp, ShaderType_Vertex);
+	sources[ShaderType_Vertex] = OS_FileRead(&scratch.arena, vsfp);
 	
 	if (!OS_FileExists(fsfp))
 		LogError("The Fragment Shader File '%s.frag.glsl' doesn't exist", fp_prefix.str);
 	else Log("Loading Fragment Shader '%s.frag.glsl'", fp_prefix.str);
-	R_ShaderAllocLoad(&shader_buffer[shader_count++], fsfp, ShaderType_Fragment);
+	sources[ShaderType_Fragment] = OS_FileRead(&scratch.arena, fsfp);
 	
 	if (OS_FileExists(gsfp)) {
 		Log("Loading Geometry Shader '%s.geom.glsl'", fp_prefix.str);
-		R_ShaderAllocLoad(&shader_buffer[shader_count++], gsfp, ShaderType_Geometry);
+		sources[ShaderType_Geometry] = OS_FileRead(&scratch.arena, gsfp);
 	}
 	
-	R_ShaderPackAlloc(_pack, shader_buffer, shader_count);
+	u64 key = R_GLProgramKey(sources, ShaderType_MAX);
+	u32 handle = R_GLProgramCacheAcquire(key);
+	if (!handle) {
+		handle = R_GLProgramLoadBinary(key);
+		if (handle) R_GLProgramCacheInsert(key, handle);
+	}
 	
-	for (u32 i = 0; i < shader_count; i++) {
-		R_ShaderFree(&shader_buffer[i]);
+	if (handle) {
+		uniform_hash_table_init(&pack->uniforms);
+		pack->handle = handle;
+		R_RegistryAdd(ResourceType_ShaderPack, pack->handle, 0);
+	} else {
+		R_Shader shader_buffer[ShaderType_MAX];
+		u32 shader_count = 0;
+		for (u32 i = 0; i < ShaderType_MAX; i++) {
+			if (i == ShaderType_Geometry && !sources[i].size) continue;
+			R_ShaderAlloc(&shader_buffer[shader_count++], sources[i], i);
+		}
+		
+		R_ShaderPackAlloc(_pack, shader_buffer, shader_count);
+		
+		for (u32 i = 0; i < shader_count; i++) {
+			R_ShaderFree(&shader_buffer[i]);
+		}
+		// A failed link is neither cached nor stored, the pack owns it and deletes it on free
+		if (R_GLProgramLinked(pack->handle)) {
+			R_GLProgramStoreBinary(key, pack->handle);
+			R_GLProgramCacheInsert(key, pack->handle);
+		}
 	}
 	
 	scratch_return(&scratch);
 }
 
-
-void R_ShaderPackUploadMat4(R_ShaderPack* _pack, string name, mat4 mat) {
-	R_GL46ShaderPack* pack = (R_GL46ShaderPack*) _pack;
+// glGetUniformLocation wants a terminated name and string slices aren't guaranteed to be one
+static i32 R_GL46ShaderPackLocation(R_GL46ShaderPack* pack, string name) {
 	i32 loc;
-    if (!uniform_hash_table_get(&pack->uniforms, name, &loc)) {
-        loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        uniform_hash_table_set(&pack->uniforms, name, loc);
-    }
-    glUniformMatrix4fv(loc, 1, GL_TRUE, mat.a);
+	if (!uniform_hash_table_get(&pack->uniforms, name, &loc)) {
+		M_Scratch scratch = scratch_get();
+		string cname = str_copy(&scratch.arena, name);
+		loc = glGetUniformLocation(pack->handle, (const GLchar*)cname.str);
+		scratch_return(&scratch);
+		uniform_hash_table_set(&pack->uniforms, name, loc);
+	}
+	return loc;
 }
 
-void R_ShaderPackUploadInt(R_ShaderPack* _pack, string name, i32 val) {
+R_Uniform R_ShaderPackGetUniform(R_ShaderPack* _pack, string name) {
 	R_GL46ShaderPack* pack = (R_GL46ShaderPack*) _pack;
-	i32 loc;
-    if (!uniform_hash_table_get(&pack->uniforms, name, &loc)) {
-        loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        uniform_hash_table_set(&pack->uniforms, name, loc);
-    }
-    glUniform1i(loc, val);
+	return (R_Uniform) { .v[0] = (u64) (i64) R_GL46ShaderPackLocation(pack, name) };
 }
 
-void R_ShaderPackUploadIntArray(R_ShaderPack* _pack, string name, i32* vals, u32 count) {
+void R_ShaderPackBindUniformBlock(R_ShaderPack* _pack, string block, u32 binding) {
 	R_GL46ShaderPack* pack = (R_GL46ShaderPack*) _pack;
-	i32 loc;
-    if (!uniform_hash_table_get(&pack->uniforms, name, &loc)) {
-        loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        uniform_hash_table_set(&pack->uniforms, name, loc);
-    }
-    glUniform1iv(loc, count, vals);
+	M_Scratch scratch = scratch_get();
+	string cblock = str_copy(&scratch.arena, block);
+	u32 index = glGetUniformBlockIndex(pack->handle, (const GLchar*)cblock.str);
+	if (index == GL_INVALID_INDEX) LogError("Uniform block '%.*s' not found", str_expand(block));
+	else glUniformBlockBinding(pack->handle, index, binding);
+	scratch_return(&scratch);
 }
 
-void R_ShaderPackUploadFloat(R_ShaderPack* _pack, string name, f32 val) {
-	R_GL46ShaderPack* pack = (R_GL46ShaderPack*) _pack;
-	i32 loc;
-    if (!uniform_hash_table_get(&pack->uniforms, name, &loc)) {
-        loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        uniform_hash_table_set(&pack->uniforms, name, loc);
-    }
-    glUniform1f(loc, val);
+void R_ShaderPackUploadMat4(R_ShaderPack* pack, string name, mat4 mat) {
+	R_UniformUploadMat4(R_ShaderPackGetUniform(pack, name), mat);
 }
 
-void R_ShaderPackUploadVec4(R_ShaderPack* _pack, string name, vec4 val) {
-	R_GL46ShaderPack* pack = (R_GL46ShaderPack*) _pack;
-	i32 loc;
-    if (!uniform_hash_table_get(&pack->uniforms, name, &loc)) {
-        loc = glGetUniformLocation(pack->handle, (const GLchar*)name.str);
-        uniform_hash_table_set(&pack->uniforms, name, loc);
-    }
-    glUniform4f(loc, val.x, val.y, val.z, val.w);
+void R_ShaderPackUploadInt(R_ShaderPack* pack, string name, i32 val) {
+	R_UniformUploadInt(R_ShaderPackGetUniform(pack, name), val);
 }
 
+void R_ShaderPackUploadIntArray(R_ShaderPack* pack, string name, i32* vals, u32 count) {
+	R_UniformUploadIntArray(R_ShaderPackGetUniform(pack, name), vals, count);
+}
+
+void R_ShaderPackUploadFloat(R_ShaderPack* pack, string name, f32 val) {
+	R_UniformUploadFloat(R_ShaderPackGetUniform(pack, name), val);
+}
+
+void R_ShaderPackUploadVec4(R_ShaderPack* pack, string name, vec4 val) {
+	R_UniformUploadVec4(R_ShaderPackGetUniform(pack, name), val);
+}
+
+void R_UniformUploadMat4(R_Uniform uniform, mat4 mat) {
+	glUniformMatrix4fv((i32) uniform.v[0], 1, GL_TRUE, mat.a);
+}
+
+void R_UniformUploadInt(R_Uniform uniform, i32 val) {
+	glUniform1i((i32) uniform.v[0], val);
+}
+
+void R_UniformUploadIntArray(R_Uniform uniform, i32* vals, u32 count) {
+	glUniform1iv((i32) uniform.v[0], count, vals);
+}
+
+void R_UniformUploadFloat(R_Uniform uniform, f32 val) {
+	glUniform1f((i32) uniform.v[0], val);
+}
+
+void R_UniformUploadVec4(R_Uniform uniform, vec4 val) {
+	glUniform4f((i32) uniform.v[0], val.x, val.y, val.z, val.w);
+}
 
 void R_ShaderPackFree(R_ShaderPack* _pack) {
 	R_GL46ShaderPack* pack = (R_GL46ShaderPack*) _pack;
 	uniform_hash_table_free(&pack->uniforms);
+	R_RegistryRemove(ResourceType_ShaderPack, pack->handle);
+	if (R_GLProgramCacheRelease(pack->handle)) return;
+	R_GLStateForget(&_gl_state.program, pack->handle);
 	glDeleteProgram(pack->handle);
 }
 
@@ -403,13 +484,14 @@ void R_PipelineAlloc(R_Pipeline* _in, R_InputAssembly assembly, R_Attribute* att
 	in->shader = (R_GL46ShaderPack*) shader;
 	in->attribute_count = attribute_count;
 	glCreateVertexArrays(1, &in->handle);
+	R_RegistryAdd(ResourceType_Pipeline, in->handle, 0);
 }
 
-void R_PipelineAddBuffer(R_Pipeline* _in, R_Buffer* _buf, u32 attribute_count) {
+void R_PipelineAddInstanceBuffer(R_Pipeline* _in, R_Buffer* _buf, u32 attribute_count, u32 divisor) {
 	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
 	R_GL46Buffer* buf = (R_GL46Buffer*) _buf;
 	
-	glBindVertexArray(in->handle);
+	R_GLStateBindVertexArray(in->handle);
 	u32 stride = 0;
 	for (u32 i = in->attribpoint; i < in->attribpoint + attribute_count; i++) {
 		stride += get_size_of(in->attributes[i]);
@@ -417,25 +499,43 @@ void R_PipelineAddBuffer(R_Pipeline* _in, R_Buffer* _buf, u32 attribute_count) {
 	
 	u32 offset = 0;
 	for (u32 i = in->attribpoint; i < in->attribpoint + attribute_count; i++) {
+		u32 type = get_type_of(in->attributes[i]);
 		glEnableVertexArrayAttrib(in->handle, i);
-		glVertexArrayAttribFormat(in->handle, i, get_component_count_of(in->attributes[i]), get_type_of(in->attributes[i]), GL_FALSE, offset);
+		if (type == GL_INT)
+			glVertexArrayAttribIFormat(in->handle, i, get_component_count_of(in->attributes[i]), type, offset);
+		else
+			glVertexArrayAttribFormat(in->handle, i, get_component_count_of(in->attributes[i]), type, GL_FALSE, offset);
 		glVertexArrayAttribBinding(in->handle, i, in->bindpoint);
 		offset += get_size_of(in->attributes[i]);
 	}
 	
 	glVertexArrayVertexBuffer(in->handle, in->bindpoint, buf->handle, 0, stride);
+	glVertexArrayBindingDivisor(in->handle, in->bindpoint, divisor);
 	
+	in->attribpoint += attribute_count;
 	in->bindpoint++;
 }
 
+void R_PipelineAddBuffer(R_Pipeline* _in, R_Buffer* _buf, u32 attribute_count) {
+	R_PipelineAddInstanceBuffer(_in, _buf, attribute_count, 0);
+}
+
+void R_PipelineSetIndexBuffer(R_Pipeline* _in, R_Buffer* _buf) {
+	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
+	R_GL46Buffer* buf = (R_GL46Buffer*) _buf;
+	glVertexArrayElementBuffer(in->handle, buf->handle);
+}
+
 void R_PipelineBind(R_Pipeline* _in) {
 	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
-	glUseProgram(in->shader->handle);
-	glBindVertexArray(in->handle);
+	R_GLStateUseProgram(in->shader->handle);
+	R_GLStateBindVertexArray(in->handle);
 }
 
 void R_PipelineFree(R_Pipeline* _in) {
 	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
+	R_GLStateForget(&_gl_state.vertex_array, in->handle);
+	R_RegistryRemove(ResourceType_Pipeline, in->handle);
 	glDeleteVertexArrays(1, &in->handle);
 }
 
@@ -450,18 +550,27 @@ void R_Texture2DAlloc(R_Texture2D* _texture, R_TextureFormat format, u32 width,
 	texture->wrap_s = wrap_s;
 	texture->wrap_t = wrap_t;texture->format = format;
 	glCreateTextures(GL_TEXTURE_2D, 1, &texture->handle);
+	R_RegistryAdd(ResourceType_Texture2D, texture->handle, R_RegistryTextureBytes(format, width, height, min));
 	
 	glTextureParameteri(texture->handle, GL_TEXTURE_WRAP_S, get_texture_wrap_param_type_of(wrap_s));
 	glTextureParameteri(texture->handle, GL_TEXTURE_WRAP_T, get_texture_wrap_param_type_of(wrap_t));
 	glTextureParameteri(texture->handle, GL_TEXTURE_MIN_FILTER, get_texture_resize_param_type_of(min));
 	glTextureParameteri(texture->handle, GL_TEXTURE_MAG_FILTER, get_texture_resize_param_type_of(mag));
 	
-	glTextureStorage2D(texture->handle, 1,
+	// Mipmapped filters get the full chain, it is filled by glGenerateTextureMipmap
+	u32 levels = 1;
+	if (min >= TextureResize_LinearMipmapLinear) {
+		for (u32 size = Max(width, height); size > 1; size >>= 1) levels++;
+	}
+	glTextureStorage2D(texture->handle, levels,
 					   get_texture_internal_format_type_of(format), width, height);
 	
 	AssertTrue(mag == TextureResize_Nearest || mag == TextureResize_Linear, "Magnification Filter for texture can only be Nearest or Linear");
 }
 
+// Async loads decode with the same orientation R_Texture2DAllocLoad uses
+#define R_GL_FLIP_ON_LOAD true
+
 void R_Texture2DAllocLoad(R_Texture2D* _texture, string filepath, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t) {
 	i32 width, height, channels;
 	stbi_set_flip_vertically_on_load(true);
@@ -502,14 +611,67 @@ b8 R_Texture2DEquals(R_Texture2D* _a, R_Texture2D* _b) {
 
 void R_Texture2DBindTo(R_Texture2D* _texture, u32 slot) {
 	R_GL46Texture2D* texture = (R_GL46Texture2D*) _texture;
-	glBindTextureUnit(slot, texture->handle);
+	R_RegistryTouch(ResourceType_Texture2D, texture->handle);
+	if (slot >= R_GL_TEXTURE_SLOTS || R_GLStateChanged(&_gl_state.textures[slot], texture->handle))
+		glBindTextureUnit(slot, texture->handle);
+}
+
+//~ Async Upload Helpers
+
+// Persistent and coherent, so it stays mapped while uploads read from it and needs no flush.
+// *mapped is null if the driver wouldn't map it
+static u32 R_GLUnpackBufferAlloc(u64 size, void** mapped) {
+	u32 handle;
+	u32 flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &handle);
+	glNamedBufferStorage(handle, size, nullptr, flags);
+	*mapped = glMapNamedBufferRange(handle, 0, size, flags);
+	R_RegistryAdd(ResourceType_Buffer, handle, size);
+	return handle;
+}
+
+static b8 R_GLUnpackBufferFinish(u32 handle) {
+	return true;
+}
+
+// Deleting unmaps it as well
+static void R_GLUnpackBufferFree(u32 handle) {
+	R_RegistryRemove(ResourceType_Buffer, handle);
+	glDeleteBuffers(1, &handle);
+}
+
+// With a pbo, data is the byte offset of the rows in it, otherwise a pointer to them
+static void R_GLTexture2DUploadRows(R_Texture2D* _texture, u32 pbo, u32 y, u32 rows, u8* data) {
+	R_GL46Texture2D* texture = (R_GL46Texture2D*) _texture;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTextureSubImage2D(texture->handle, 0, 0, y, texture->width, rows, get_texture_format_type_of(texture->format), get_texture_datatype_of(texture->format), data);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+static void R_GLTexture2DGenerateMipmaps(R_Texture2D* _texture) {
+	R_GL46Texture2D* texture = (R_GL46Texture2D*) _texture;
+	glGenerateTextureMipmap(texture->handle);
 }
 
 void R_Texture2DFree(R_Texture2D* _texture) {
 	R_GL46Texture2D* texture = (R_GL46Texture2D*) _texture;
+	R_TextureLoadCancel(_texture);
+	R_GLStateForgetTexture(texture->handle);
+	R_RegistryRemove(ResourceType_Texture2D, texture->handle);
 	glDeleteTextures(1, &texture->handle);
 }
 
+static u32 R_GLTexture2DHandle(R_Texture2D* _texture) {
+	return ((R_GL46Texture2D*) _texture)->handle;
+}
+
+void R_Texture2DSetEvictable(R_Texture2D* _texture, R_TextureEvictFunc* evict, void* user) {
+	R_GL46Texture2D* texture = (R_GL46Texture2D*) _texture;
+	R_RegistrySetEvict(ResourceType_Texture2D, texture->handle, evict, user);
+}
+
 //~ Framebuffers
 
 void R_FramebufferCreate(R_Framebuffer* _framebuffer, u32 width, u32 height, R_Texture2D* color_attachments, u32 color_attachment_count, R_Texture2D depth_attachment) {
@@ -517,7 +679,8 @@ void R_FramebufferCreate(R_Framebuffer* _framebuffer, u32 width, u32 height, R_T
 	if (!height) height = 1;
 	R_GL46Framebuffer* ret = (R_GL46Framebuffer*) _framebuffer;
 	glCreateFramebuffers(1, &ret->handle);
-    glBindFramebuffer(GL_FRAMEBUFFER, ret->handle);
+	R_RegistryAdd(ResourceType_Framebuffer, ret->handle, 0);
+    R_GLStateBindFramebuffer(GL_FRAMEBUFFER, ret->handle);
 	ret->width = width;
     ret->height = height;
 	ret->color_attachments = malloc(sizeof(R_Texture2D) * color_attachment_count);
@@ -545,11 +708,11 @@ void R_FramebufferCreate(R_Framebuffer* _framebuffer, u32 width, u32 height, R_T
 
 void R_FramebufferBind(R_Framebuffer* _framebuffer) {
 	R_GL46Framebuffer* framebuffer = (R_GL46Framebuffer*) _framebuffer;
-	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
+	R_GLStateBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
 }
 
 void R_FramebufferBindScreen(void) {
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	R_GLStateBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void R_FramebufferBlitToScreen(OS_Window* window, R_Framebuffer* _framebuffer) {
@@ -568,6 +731,70 @@ void R_FramebufferReadPixel(R_Framebuffer* _framebuffer, u32 attachment, u32 x,
     glReadPixels(x, y, 1, 1, get_texture_format_type_of(format), get_texture_datatype_of(format), data);
 }
 
+//~ Readback
+
+void R_ReadbackAlloc(R_Readback* _readback, u64 size) {
+	R_GL46Readback* readback = (R_GL46Readback*) _readback;
+	MemoryZero(readback, sizeof(R_GL46Readback));
+	readback->size = size;
+	glCreateBuffers(1, &readback->pbo);
+	glNamedBufferStorage(readback->pbo, size, nullptr, GL_CLIENT_STORAGE_BIT);
+	R_RegistryAdd(ResourceType_Buffer, readback->pbo, size);
+}
+
+void R_FramebufferReadRegionAsync(R_Readback* _readback, R_Framebuffer* _framebuffer, u32 attachment,
+								  u32 x, u32 y, u32 w, u32 h) {
+	R_GL46Readback* readback = (R_GL46Readback*) _readback;
+	R_GL46Framebuffer* framebuffer = (R_GL46Framebuffer*) _framebuffer;
+	R_TextureFormat format = framebuffer->color_attachments[attachment].format;
+	u64 bytes = (u64) w * h * get_texture_pixel_size_of(format);
+	AssertTrue(bytes <= readback->size, "Readback region is bigger than its buffer");
+	if (bytes > readback->size) return;
+	
+	R_GLStateBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer->handle);
+	glNamedFramebufferReadBuffer(framebuffer->handle, GL_COLOR_ATTACHMENT0 + attachment);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->pbo);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	// With a pack buffer bound this only queues the copy, nothing waits on the GPU here
+	glReadPixels(x, y, w, h, get_texture_format_type_of(format), get_texture_datatype_of(format), nullptr);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	
+	// A newer request supersedes one still in flight
+	if (readback->fence) glDeleteSync(readback->fence);
+	readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback->bytes = bytes;
+}
+
+void R_FramebufferReadPixelAsync(R_Readback* readback, R_Framebuffer* framebuffer, u32 attachment, u32 x, u32 y) {
+	R_FramebufferReadRegionAsync(readback, framebuffer, attachment, x, y, 1, 1);
+}
+
+b8 R_ReadbackIsPending(R_Readback* _readback) {
+	R_GL46Readback* readback = (R_GL46Readback*) _readback;
+	return readback->fence != nullptr;
+}
+
+b8 R_ReadbackPoll(R_Readback* _readback, void* data) {
+	R_GL46Readback* readback = (R_GL46Readback*) _readback;
+	if (!readback->fence) return false;
+	// Zero timeout, the swap flushes the fence so it signals without being forced here
+	GLenum status = glClientWaitSync(readback->fence, 0, 0);
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+	
+	glDeleteSync(readback->fence);
+	readback->fence = nullptr;
+	glGetNamedBufferSubData(readback->pbo, 0, readback->bytes, data);
+	return true;
+}
+
+void R_ReadbackFree(R_Readback* _readback) {
+	R_GL46Readback* readback = (R_GL46Readback*) _readback;
+	if (readback->fence) glDeleteSync(readback->fence);
+	R_RegistryRemove(ResourceType_Buffer, readback->pbo);
+	glDeleteBuffers(1, &readback->pbo);
+}
+
 static void R_FramebufferDeleteInternal(R_Framebuffer* _framebuffer) {
 	R_GL46Framebuffer* framebuffer = (R_GL46Framebuffer*) _framebuffer;
 	for (u32 i = 0; i < framebuffer->color_attachment_count; i++) {
@@ -575,22 +802,30 @@ static void R_FramebufferDeleteInternal(R_Framebuffer* _framebuffer) {
     }
     if (framebuffer->depth_attachment.format != TextureFormat_Invalid)
         R_Texture2DFree(&framebuffer->depth_attachment);
+    R_GLStateForget(&_gl_state.draw_framebuffer, framebuffer->handle);
+    R_GLStateForget(&_gl_state.read_framebuffer, framebuffer->handle);
+    R_RegistryRemove(ResourceType_Framebuffer, framebuffer->handle);
     glDeleteFramebuffers(1, &framebuffer->handle);
 }
 
 void R_FramebufferResize(R_Framebuffer* _framebuffer, u32 new_width, u32 new_height) {
-	R_FramebufferDeleteInternal(_framebuffer);
 	R_GL46Framebuffer* framebuffer = (R_GL46Framebuffer*) _framebuffer;
+	// The recreated objects are reported where the framebuffer was created
+	R_RegistrySite site = R_RegistrySiteOf(ResourceType_Framebuffer, framebuffer->handle);
+	R_FramebufferDeleteInternal(_framebuffer);
     
 	if (!new_width) new_width = 1;
     if (!new_height) new_height = 1;
     glCreateFramebuffers(1, &framebuffer->handle);
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
+    R_RegistrySiteSet(site);
+    R_RegistryAdd(ResourceType_Framebuffer, framebuffer->handle, 0);
+    R_GLStateBindFramebuffer(GL_FRAMEBUFFER, framebuffer->handle);
     framebuffer->width = new_width;
     framebuffer->height = new_height;
 	
     for (u32 i = 0; i < framebuffer->color_attachment_count; i++) {
         R_Texture2D old_spec = framebuffer->color_attachments[i];
+        R_RegistrySiteSet(site);
 		R_Texture2DAlloc(&framebuffer->color_attachments[i], old_spec.format, new_width, new_height, old_spec.min, old_spec.mag, old_spec.wrap_s, old_spec.wrap_t);
         glNamedFramebufferTexture(framebuffer->handle, GL_COLOR_ATTACHMENT0 + i, ((R_GL46Texture2D*)&framebuffer->color_attachments[i])->handle, 0, 0);
     }
@@ -599,6 +834,7 @@ void R_FramebufferResize(R_Framebuffer* _framebuffer, u32 new_width, u32 new_hei
         AssertTrue(framebuffer->depth_attachment.format == TextureFormat_DepthStencil, "Depth Texture format is not TextureFormat_DepthStencil");
         
         R_Texture2D old_spec = framebuffer->depth_attachment;
+        R_RegistrySiteSet(site);
 		R_Texture2DAlloc(&framebuffer->depth_attachment, old_spec.format, new_width, new_height, old_spec.min, old_spec.mag, old_spec.wrap_s, old_spec.wrap_t);
         glNamedFramebufferTexture(framebuffer->handle, GL_DEPTH_STENCIL_ATTACHMENT, ((R_GL46Texture2D*)&framebuffer->depth_attachment)->handle, 0, 0);
     }
@@ -616,6 +852,9 @@ void R_FramebufferFree(R_Framebuffer* _framebuffer) {
 	free(framebuffer->color_attachments);
     if (framebuffer->depth_attachment.format != TextureFormat_Invalid)
         R_Texture2DFree(&framebuffer->depth_attachment);
+    R_GLStateForget(&_gl_state.draw_framebuffer, framebuffer->handle);
+    R_GLStateForget(&_gl_state.read_framebuffer, framebuffer->handle);
+    R_RegistryRemove(ResourceType_Framebuffer, framebuffer->handle);
     glDeleteFramebuffers(1, &framebuffer->handle);
 }
 
@@ -637,24 +876,95 @@ void R_Viewport(i32 x, i32 y, i32 w, i32 h) {
 	glViewport(x, y, w, h);
 }
 
+void R_ScissorEnable(i32 x, i32 y, i32 w, i32 h) {
+	R_GLStateToggle(&_gl_state.scissor, GL_SCISSOR_TEST, true);
+	R_GLStateScissorRect(x, y, w, h);
+}
+
+void R_ScissorDisable(void) {
+	R_GLStateToggle(&_gl_state.scissor, GL_SCISSOR_TEST, false);
+}
+
 void R_BlendDisable(void) {
-	glDisable(GL_BLEND);
+	R_GLStateToggle(&_gl_state.blend, GL_BLEND, false);
 }
 
 void R_BlendAlpha(void) {
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	R_GLStateToggle(&_gl_state.blend, GL_BLEND, true);
+	R_GLStateBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void R_DepthEnable(void) {
-	glEnable(GL_DEPTH_TEST);
+	R_GLStateToggle(&_gl_state.depth, GL_DEPTH_TEST, true);
 }
 
 void R_DepthDisable(void) {
-	glDisable(GL_DEPTH_TEST);
+	R_GLStateToggle(&_gl_state.depth, GL_DEPTH_TEST, false);
+}
+
+void R_Cull(R_CullFace to_cull) {
+	switch (to_cull) {
+		case CullFace_None:  R_GLStateToggle(&_gl_state.cull, GL_CULL_FACE, false); break;
+		case CullFace_Back:  R_GLStateToggle(&_gl_state.cull, GL_CULL_FACE, true); R_GLStateCullFace(GL_BACK); break;
+		case CullFace_Front: R_GLStateToggle(&_gl_state.cull, GL_CULL_FACE, true); R_GLStateCullFace(GL_FRONT); break;
+	}
 }
 
 void R_Draw(R_Pipeline* _in, u32 start, u32 count) {
 	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
 	glDrawArrays(get_input_assembly_type_of(in->assembly), start, count);
 }
+
+void R_DrawIndexed(R_Pipeline* _in, u32 start, u32 count) {
+	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
+	glDrawElements(get_input_assembly_type_of(in->assembly), count, GL_UNSIGNED_INT, (void*) (u64) (start * sizeof(u32)));
+}
+
+void R_DrawInstanced(R_Pipeline* _in, u32 start, u32 count, u32 instance_count) {
+	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
+	glDrawArraysInstanced(get_input_assembly_type_of(in->assembly), start, count, instance_count);
+}
+
+void R_DrawIndexedInstanced(R_Pipeline* _in, u32 start, u32 count, u32 instance_count) {
+	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
+	glDrawElementsInstanced(get_input_assembly_type_of(in->assembly), count, GL_UNSIGNED_INT, (void*) (u64) (start * sizeof(u32)), instance_count);
+}
+
+void R_MultiDrawIndirect(R_Pipeline* _in, R_Buffer* _commands, u32 draw_count) {
+	R_GL46Pipeline* in = (R_GL46Pipeline*) _in;
+	R_GL46Buffer* commands = (R_GL46Buffer*) _commands;
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands->handle);
+	glMultiDrawArraysIndirect(get_input_assembly_type_of(in->assembly), nullptr, draw_count, sizeof(R_DrawIndirectCommand));
+}
+
+//~ State Cache
+
+R_StateStats R_StateStatsGet(void) {
+	return _gl_state.stats;
+}
+
+void R_StateStatsReset(void) {
+	_gl_state.stats = (R_StateStats) {0};
+}
+
+void R_StateInvalidate(void) {
+	R_GLStateInvalidate();
+}
+
+//~ GPU Timers
+
+void R_GpuTimerBegin(string name) {
+	R_GLTimerBegin(name);
+}
+
+void R_GpuTimerEnd(void) {
+	R_GLTimerEnd();
+}
+
+void R_GpuTimerFrameEnd(void) {
+	R_GLTimerFrameEnd();
+}
+
+R_GpuReport* R_GpuTimerReport(void) {
+	return &_gl_timers.report;
+}
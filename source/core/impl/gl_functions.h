@@ -35,18 +35,38 @@ typedef i64 GLint64;
 typedef i64 GLint64EXT;
 typedef u64 GLuint64;
 typedef u64 GLuint64EXT;
+typedef struct __GLsync* GLsync;
 
 #define GL_FALSE 0
 #define GL_TRUE 1
 
 #define GL_ARRAY_BUFFER 0x8892
+#define GL_UNIFORM_BUFFER 0x8A11
+#define GL_INVALID_INDEX 0xFFFFFFFF
 #define GL_ELEMENT_ARRAY_BUFFER 0x8893
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#define GL_UNPACK_ALIGNMENT 0x0CF5
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#define GL_PACK_ALIGNMENT 0x0D05
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_TIMESTAMP 0x8E28
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
 
 #define GL_INFO_LOG_LENGTH 0x8B84
 
 #define GL_DELETE_STATUS 0x8B80
 #define GL_COMPILE_STATUS 0x8B81
 #define GL_LINK_STATUS 0x8B82
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_VENDOR 0x1F00
+#define GL_RENDERER 0x1F01
+#define GL_VERSION 0x1F02
 #define GL_VALIDATE_STATUS 0x8B83
 
 #define GL_STREAM_DRAW 0x88E0
@@ -87,6 +107,9 @@ typedef u64 GLuint64EXT;
 #define GL_STENCIL_BUFFER_BIT 0x00000400
 #define GL_COLOR_BUFFER_BIT 0x00004000
 
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
 #define GL_MAP_PERSISTENT_BIT 0x0040
 #define GL_MAP_COHERENT_BIT 0x0080
 #define GL_DYNAMIC_STORAGE_BIT 0x0100
@@ -166,6 +189,7 @@ typedef u64 GLuint64EXT;
 #define GL_DEPTH_TEST 0x0B71
 
 #define GL_CULL_FACE 0x0B44
+#define GL_SCISSOR_TEST 0x0C11
 #define GL_NONE 0
 #define GL_FRONT_LEFT 0x0400
 #define GL_FRONT_RIGHT 0x0401
@@ -183,6 +207,8 @@ typedef u64 GLuint64EXT;
 X(glGenBuffers, void, (GLsizei count, GLuint* buffer_handles))\
 X(glBindBuffer, void, (GLenum target, GLuint buffer_handle))\
 X(glBufferData, void, (GLenum target, GLsizeiptr size, const void* data, GLenum usage))\
+X(glMapBufferRange, void*, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access))\
+X(glUnmapBuffer, GLboolean, (GLenum target))\
 X(glBufferSubData, void, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data))\
 X(glDeleteBuffers, void, (GLsizei count, const GLuint* buffer_handles))\
 X(glCreateShader, u32, (GLenum type))\
@@ -201,16 +227,29 @@ X(glUniform1i, void, (GLint location, GLint value))\
 X(glUniform1iv, void, (GLint location, GLuint count, GLint* values))\
 X(glUniform1f, void, (GLint location, GLfloat value))\
 X(glUniform4f, void, (GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w))\
+X(glGetUniformBlockIndex, GLuint, (GLuint program_handle, const GLchar* block_name))\
+X(glUniformBlockBinding, void, (GLuint program_handle, GLuint block_index, GLuint binding))\
+X(glBindBufferBase, void, (GLenum target, GLuint index, GLuint buffer_handle))\
 X(glGetProgramiv, void, (GLuint program_handle, GLenum param_name, GLint* values))\
 X(glGetProgramInfoLog, void, (GLuint program_handle, GLsizei buf_size, GLsizei* length, GLchar* log))\
 X(glDetachShader, void, (GLuint program_handle, GLuint shader_handle))\
 X(glDeleteProgram, void, (GLuint program_handle))\
+X(glProgramParameteri, void, (GLuint program_handle, GLenum pname, GLint value))\
+X(glGetProgramBinary, void, (GLuint program_handle, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary))\
+X(glProgramBinary, void, (GLuint program_handle, GLenum binary_format, const void* binary, GLsizei length))\
+X(glGetString, const GLubyte*, (GLenum name))\
 X(glGenVertexArrays, void, (GLsizei count, GLuint* vao_handles))\
 X(glBindVertexArray, void, (GLuint vao_handle))\
 X(glVertexAttribPointer, void, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer))\
 X(glEnableVertexAttribArray, void, (GLuint index))\
+X(glVertexAttribIPointer, void, (GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer))\
+X(glVertexAttribDivisor, void, (GLuint index, GLuint divisor))\
 X(glDeleteVertexArrays, void, (GLsizei count, const GLuint* vao_handles))\
 X(glDrawArrays, void, (GLenum mode, GLint first, GLsizei count))\
+X(glDrawArraysInstanced, void, (GLenum mode, GLint first, GLsizei count, GLsizei instance_count))\
+X(glDrawElements, void, (GLenum mode, GLsizei count, GLenum type, const void* indices))\
+X(glDrawElementsInstanced, void, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instance_count))\
+X(glGetBufferSubData, void, (GLenum target, GLintptr offset, GLsizeiptr size, void* data))\
 X(glClear, void, (GLbitfield mask))\
 X(glClearColor, void, (GLfloat r, GLfloat g, GLfloat b, GLfloat a))\
 X(glGenTextures, void, (GLsizei count, GLuint* texture_handles))\
@@ -220,9 +259,12 @@ X(glTexParameteri, void, (GLenum target, GLenum pname, GLint param))\
 X(glTexParameteriv, void, (GLenum target, GLenum pname, GLint* params))\
 X(glActiveTexture, void, (GLenum texture_handle))\
 X(glTexSubImage2D, void, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void* data))\
+X(glGenerateMipmap, void, (GLenum target))\
+X(glPixelStorei, void, (GLenum pname, GLint param))\
 X(glDeleteTextures, void, (GLsizei count, GLuint* texture_handles))\
 X(glFlush, void, (void))\
 X(glViewport, void, (GLint x, GLint y, GLsizei w, GLsizei h))\
+X(glScissor, void, (GLint x, GLint y, GLsizei w, GLsizei h))\
 X(glEnable, void, (GLenum feature))\
 X(glDisable, void, (GLenum feature))\
 X(glBlendFunc, void, (GLenum src_factor, GLenum dst_factor))\
@@ -236,13 +278,25 @@ X(glBindFramebuffer, void, (GLenum target, GLuint framebuffer_handle))\
 X(glBlitFramebuffer, void, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter))\
 X(glDeleteFramebuffers, void, (GLsizei count, GLuint* fbo_handles))\
 X(glCullFace, void, (GLenum mode))\
+X(glGenQueries, void, (GLsizei count, GLuint* query_handles))\
+X(glDeleteQueries, void, (GLsizei count, const GLuint* query_handles))\
+X(glQueryCounter, void, (GLuint query_handle, GLenum target))\
+X(glGetQueryObjectiv, void, (GLuint query_handle, GLenum pname, GLint* params))\
+X(glGetQueryObjectui64v, void, (GLuint query_handle, GLenum pname, u64* params))\
+X(glPushDebugGroup, void, (GLenum source, GLuint id, GLsizei length, const GLchar* message))\
+X(glPopDebugGroup, void, (void))\
+X(glFenceSync, GLsync, (GLenum condition, GLbitfield flags))\
+X(glClientWaitSync, GLenum, (GLsync sync, GLbitfield flags, GLuint64 timeout))\
+X(glDeleteSync, void, (GLsync sync))\
 
 #elif defined(BACKEND_GL46)
 
 #  define GL_FUNCTIONS \
 X(glCreateBuffers, void, (GLsizei count, GLuint* buffer_handles))\
 X(glNamedBufferStorage, void, (GLuint buffer_handle, GLsizeiptr size, const void* data, GLbitfield flags))\
+X(glMapNamedBufferRange, void*, (GLuint buffer_handle, GLintptr offset, GLsizeiptr length, GLbitfield access))\
 X(glNamedBufferSubData, void, (GLuint buffer_handle, GLintptr offset, GLsizeiptr size, const void* data))\
+X(glGetNamedBufferSubData, void, (GLuint buffer_handle, GLintptr offset, GLsizeiptr size, void* data))\
 X(glDeleteBuffers, void, (GLsizei count, const GLuint* buffer_handles))\
 X(glCreateShader, u32, (GLenum type))\
 X(glShaderSource, void, (GLuint shader_handle, GLsizei count, const GLchar* const* str, const GLint* length))\
@@ -259,19 +313,33 @@ X(glUniform1i, void, (GLint location, GLint value))\
 X(glUniform1iv, void, (GLint location, GLuint count, GLint* values))\
 X(glUniform1f, void, (GLint location, GLfloat value))\
 X(glUniform4f, void, (GLint location, GLfloat x, GLfloat y, GLfloat z, GLfloat w))\
+X(glGetUniformBlockIndex, GLuint, (GLuint program_handle, const GLchar* block_name))\
+X(glUniformBlockBinding, void, (GLuint program_handle, GLuint block_index, GLuint binding))\
+X(glBindBufferBase, void, (GLenum target, GLuint index, GLuint buffer_handle))\
 X(glUseProgram, void, (GLuint program_handle))\
 X(glGetProgramiv, void, (GLuint program_handle, GLenum param_name, GLint* values))\
 X(glGetProgramInfoLog, void, (GLuint program_handle, GLsizei buf_size, GLsizei* length, GLchar* log))\
 X(glDetachShader, void, (GLuint program_handle, GLuint shader_handle))\
 X(glDeleteProgram, void, (GLuint program_handle))\
+X(glProgramParameteri, void, (GLuint program_handle, GLenum pname, GLint value))\
+X(glGetProgramBinary, void, (GLuint program_handle, GLsizei buf_size, GLsizei* length, GLenum* binary_format, void* binary))\
+X(glProgramBinary, void, (GLuint program_handle, GLenum binary_format, const void* binary, GLsizei length))\
+X(glGetString, const GLubyte*, (GLenum name))\
 X(glCreateVertexArrays, void, (GLsizei count, GLuint* vao_handles))\
 X(glBindVertexArray, void, (GLuint vao_handle))\
 X(glVertexArrayAttribFormat, void, (GLuint vao_handle, GLuint attribute_index, GLint size, GLenum type, GLboolean normalized, GLuint relative_offset))\
 X(glVertexArrayAttribBinding, void, (GLuint vao_handle, GLuint attribute_index, GLuint binding_index))\
+X(glVertexArrayAttribIFormat, void, (GLuint vao_handle, GLuint attribute_index, GLint size, GLenum type, GLuint relative_offset))\
+X(glVertexArrayBindingDivisor, void, (GLuint vao_handle, GLuint binding_index, GLuint divisor))\
+X(glVertexArrayElementBuffer, void, (GLuint vao_handle, GLuint buffer_handle))\
 X(glVertexArrayVertexBuffer, void, (GLuint vao_handle, GLuint binding_index, GLuint buffer_handle, GLintptr offset, GLsizei stride))\
 X(glEnableVertexArrayAttrib, void, (GLuint vao_handle, GLuint index))\
 X(glDeleteVertexArrays, void, (GLsizei count, const GLuint* vao_handles))\
 X(glDrawArrays, void, (GLenum mode, GLint first, GLsizei count))\
+X(glDrawArraysInstanced, void, (GLenum mode, GLint first, GLsizei count, GLsizei instance_count))\
+X(glDrawElements, void, (GLenum mode, GLsizei count, GLenum type, const void* indices))\
+X(glDrawElementsInstanced, void, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instance_count))\
+X(glMultiDrawArraysIndirect, void, (GLenum mode, const void* indirect, GLsizei draw_count, GLsizei stride))\
 X(glClear, void, (GLbitfield mask))\
 X(glClearColor, void, (GLfloat r, GLfloat g, GLfloat b, GLfloat a))\
 X(glCreateTextures, void, (GLenum type, GLsizei count, GLuint* texture_handles))\
@@ -282,8 +350,11 @@ X(glTextureParameteriv, void, (GLuint texture_handle, GLenum pname, GLint* param
 X(glTextureSubImage2D, void, (GLuint texture_handle, GLint level, GLint xoffset, GLint yoffset, GLsizei width,\
 GLsizei height, GLenum format, GLenum type, const void* data))\
 X(glDeleteTextures, void, (GLsizei count, GLuint* texture_handles))\
+X(glGenerateTextureMipmap, void, (GLuint texture_handle))\
+X(glPixelStorei, void, (GLenum pname, GLint param))\
 X(glFlush, void, (void))\
 X(glViewport, void, (GLint x, GLint y, GLsizei w, GLsizei h))\
+X(glScissor, void, (GLint x, GLint y, GLsizei w, GLsizei h))\
 X(glEnable, void, (GLenum feature))\
 X(glDisable, void, (GLenum feature))\
 X(glBlendFunc, void, (GLenum src_factor, GLenum dst_factor))\
@@ -294,9 +365,22 @@ X(glNamedFramebufferReadBuffer, void, (GLuint fbo_handle, GLenum read_buffer))\
 X(glReadPixels, void, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels))\
 X(glCheckNamedFramebufferStatus, GLenum, (GLuint fbo_handle, GLenum target))\
 X(glBindFramebuffer, void, (GLenum target, GLuint framebuffer_handle))\
+X(glBindBuffer, void, (GLenum target, GLuint buffer_handle))\
+X(glBindTexture, void, (GLenum target, GLuint texture_handle))\
+X(glActiveTexture, void, (GLenum texture_handle))\
 X(glBlitNamedFramebuffer, void, (GLuint read_fbo_handle, GLuint draw_fbo_handle, GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter))\
 X(glDeleteFramebuffers, void, (GLsizei count, GLuint* fbo_handles))\
 X(glCullFace, void, (GLenum mode))\
+X(glGenQueries, void, (GLsizei count, GLuint* query_handles))\
+X(glDeleteQueries, void, (GLsizei count, const GLuint* query_handles))\
+X(glQueryCounter, void, (GLuint query_handle, GLenum target))\
+X(glGetQueryObjectiv, void, (GLuint query_handle, GLenum pname, GLint* params))\
+X(glGetQueryObjectui64v, void, (GLuint query_handle, GLenum pname, u64* params))\
+X(glPushDebugGroup, void, (GLenum source, GLuint id, GLsizei length, const GLchar* message))\
+X(glPopDebugGroup, void, (void))\
+X(glFenceSync, GLsync, (GLenum condition, GLbitfield flags))\
+X(glClientWaitSync, GLenum, (GLsync sync, GLbitfield flags, GLuint64 timeout))\
+X(glDeleteSync, void, (GLsync sync))\
 
 #endif
 
@@ -0,0 +1,149 @@
+/* date = October 19th 2026 4:10 pm */
+
+#ifndef GL_PROGRAM_CACHE_H
+#define GL_PROGRAM_CACHE_H
+
+#include "gl_functions.h"
+#include "gl_state.h"
+
+// Linked programs keyed by their sources and the driver they were linked on.
+// In-process entries outlive the packs using them so a plugin re-init skips the link entirely,
+// and program binaries on disk skip the compile on the next run. Entries live for the whole process,
+// once the table is full the least recently used one nothing holds is deleted to make room
+#define R_GL_PROGRAM_CACHE_CAP 64
+#define R_GL_PROGRAM_CACHE_DIR "cache/shaders"
+
+typedef struct R_GLProgramEntry {
+	u64 key;
+	u32 handle;
+	u32 refs;
+	u64 last_used;
+} R_GLProgramEntry;
+
+typedef struct R_GLProgramCache {
+	R_GLProgramEntry entries[R_GL_PROGRAM_CACHE_CAP];
+	u32 count;
+	u64 clock;
+	u64 driver_hash;
+} R_GLProgramCache;
+
+static R_GLProgramCache _gl_programs = {0};
+
+static b8 R_GLProgramBinarySupported(void) {
+	return glGetProgramBinary && glProgramBinary && glProgramParameteri;
+}
+
+static b8 R_GLProgramLinked(u32 handle) {
+	i32 ret = 0;
+	glGetProgramiv(handle, GL_LINK_STATUS, &ret);
+	return ret != GL_FALSE;
+}
+
+static u64 R_GLProgramKey(string* sources, u32 source_count) {
+	if (!_gl_programs.driver_hash) {
+		u64 hash = U_HASH_SEED;
+		u32 names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		for (u32 i = 0; i < ArrayCount(names); i++) {
+			const char* name = (const char*) glGetString(names[i]);
+			if (name) hash = U_HashBytes(hash, (void*) name, strlen(name));
+		}
+		_gl_programs.driver_hash = hash;
+	}
+
+	u64 key = _gl_programs.driver_hash;
+	for (u32 i = 0; i < source_count; i++) {
+		key = U_HashBytes(key, &sources[i].size, sizeof(u64));
+		key = U_HashBytes(key, sources[i].str, sources[i].size);
+	}
+	return key;
+}
+
+static u32 R_GLProgramCacheAcquire(u64 key) {
+	for (u32 i = 0; i < _gl_programs.count; i++) {
+		if (_gl_programs.entries[i].key == key) {
+			_gl_programs.entries[i].refs++;
+			_gl_programs.entries[i].last_used = ++_gl_programs.clock;
+			return _gl_programs.entries[i].handle;
+		}
+	}
+	return 0;
+}
+
+// Leaves the program uncached when every entry is still held, the caller keeps owning it then
+static void R_GLProgramCacheInsert(u64 key, u32 handle) {
+	R_GLProgramEntry* slot = nullptr;
+	if (_gl_programs.count < R_GL_PROGRAM_CACHE_CAP) {
+		slot = &_gl_programs.entries[_gl_programs.count++];
+	} else {
+		for (u32 i = 0; i < _gl_programs.count; i++) {
+			R_GLProgramEntry* e = &_gl_programs.entries[i];
+			if (e->refs) continue;
+			if (!slot || e->last_used < slot->last_used) slot = e;
+		}
+		if (!slot) return;
+		R_GLStateForget(&_gl_state.program, slot->handle);
+		glDeleteProgram(slot->handle);
+	}
+	*slot = (R_GLProgramEntry) { key, handle, 1, ++_gl_programs.clock };
+}
+
+// False if the program isn't cached, in which case the caller owns it and should delete it
+static b8 R_GLProgramCacheRelease(u32 handle) {
+	for (u32 i = 0; i < _gl_programs.count; i++) {
+		if (_gl_programs.entries[i].handle == handle) {
+			if (_gl_programs.entries[i].refs) _gl_programs.entries[i].refs--;
+			return true;
+		}
+	}
+	return false;
+}
+
+static string R_GLProgramBinaryPath(M_Arena* arena, u64 key) {
+	return str_from_format(arena, R_GL_PROGRAM_CACHE_DIR"/%016llx.bin", key);
+}
+
+// Returns 0 when there is no usable binary, a driver update rejects old ones as well
+static u32 R_GLProgramLoadBinary(u64 key) {
+	if (!R_GLProgramBinarySupported()) return 0;
+
+	M_Scratch scratch = scratch_get();
+	string path = R_GLProgramBinaryPath(&scratch.arena, key);
+	u32 handle = 0;
+
+	if (OS_FileExists(path)) {
+		string data = OS_FileRead(&scratch.arena, path);
+		if (data.size > sizeof(u32)) {
+			u32 format = *(u32*) data.str;
+			handle = glCreateProgram();
+			glProgramBinary(handle, format, data.str + sizeof(u32), data.size - sizeof(u32));
+			if (!R_GLProgramLinked(handle)) {
+				glDeleteProgram(handle);
+				handle = 0;
+			}
+		}
+	}
+
+	scratch_return(&scratch);
+	return handle;
+}
+
+static void R_GLProgramStoreBinary(u64 key, u32 handle) {
+	if (!R_GLProgramBinarySupported()) return;
+
+	i32 length = 0;
+	glGetProgramiv(handle, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	M_Scratch scratch = scratch_get();
+	string data = str_alloc(&scratch.arena, sizeof(u32) + length);
+	u32 format = 0;
+	glGetProgramBinary(handle, length, nullptr, &format, data.str + sizeof(u32));
+	*(u32*) data.str = format;
+
+	OS_FileCreateDir(str_lit("cache"));
+	OS_FileCreateDir(str_lit(R_GL_PROGRAM_CACHE_DIR));
+	OS_FileCreateWrite(R_GLProgramBinaryPath(&scratch.arena, key), data);
+	scratch_return(&scratch);
+}
+
+#endif //GL_PROGRAM_CACHE_H
@@ -0,0 +1,141 @@
+/* date = October 19th 2026 2:40 pm */
+
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include "gl_functions.h"
+
+// Shadow copy of the GL state the backends touch, so redundant binds and toggles never reach the driver.
+// Zeroes match a fresh context, R_GL_UNKNOWN forces the next call through
+#define R_GL_UNKNOWN 0xFFFFFFFF
+#define R_GL_TEXTURE_SLOTS 32
+
+typedef struct R_GLState {
+	u32 program;
+	u32 vertex_array;
+	u32 array_buffer;
+	u32 draw_framebuffer;
+	u32 read_framebuffer;
+	u32 active_slot;
+	u32 textures[R_GL_TEXTURE_SLOTS];
+
+	u32 blend;
+	u32 blend_src;
+	u32 blend_dst;
+	u32 depth;
+	u32 scissor;
+	i32 scissor_rect[4];
+	u32 cull;
+	u32 cull_face;
+
+	R_StateStats stats;
+} R_GLState;
+
+static R_GLState _gl_state = {
+	.blend_src = R_GL_UNKNOWN,
+	.cull_face = R_GL_UNKNOWN,
+	.scissor_rect = { -1, -1, -1, -1 },
+};
+
+static b8 R_GLStateChanged(u32* cached, u32 value) {
+	if (*cached == value) {
+		_gl_state.stats.skipped++;
+		return false;
+	}
+	*cached = value;
+	_gl_state.stats.issued++;
+	return true;
+}
+
+static void R_GLStateUseProgram(u32 handle) {
+	if (R_GLStateChanged(&_gl_state.program, handle)) glUseProgram(handle);
+}
+
+static void R_GLStateBindVertexArray(u32 handle) {
+	if (R_GLStateChanged(&_gl_state.vertex_array, handle)) glBindVertexArray(handle);
+}
+
+static void R_GLStateBindArrayBuffer(u32 handle) {
+	if (R_GLStateChanged(&_gl_state.array_buffer, handle)) glBindBuffer(GL_ARRAY_BUFFER, handle);
+}
+
+static void R_GLStateBindFramebuffer(u32 target, u32 handle) {
+	if (target == GL_FRAMEBUFFER) {
+		if (_gl_state.draw_framebuffer == handle && _gl_state.read_framebuffer == handle) {
+			_gl_state.stats.skipped++;
+			return;
+		}
+		_gl_state.draw_framebuffer = handle;
+		_gl_state.read_framebuffer = handle;
+		_gl_state.stats.issued++;
+		glBindFramebuffer(target, handle);
+	} else if (target == GL_DRAW_FRAMEBUFFER) {
+		if (R_GLStateChanged(&_gl_state.draw_framebuffer, handle)) glBindFramebuffer(target, handle);
+	} else if (target == GL_READ_FRAMEBUFFER) {
+		if (R_GLStateChanged(&_gl_state.read_framebuffer, handle)) glBindFramebuffer(target, handle);
+	}
+}
+
+static void R_GLStateActiveSlot(u32 slot) {
+	if (R_GLStateChanged(&_gl_state.active_slot, slot)) glActiveTexture(GL_TEXTURE0 + slot);
+}
+
+// Binds to the active slot, which is what non-DSA uploads go through as well
+static void R_GLStateBindTexture(u32 handle) {
+	u32 slot = _gl_state.active_slot;
+	if (slot >= R_GL_TEXTURE_SLOTS) {
+		glBindTexture(GL_TEXTURE_2D, handle);
+		return;
+	}
+	if (R_GLStateChanged(&_gl_state.textures[slot], handle)) glBindTexture(GL_TEXTURE_2D, handle);
+}
+
+static void R_GLStateToggle(u32* cached, u32 capability, b8 enable) {
+	if (!R_GLStateChanged(cached, enable)) return;
+	if (enable) glEnable(capability);
+	else glDisable(capability);
+}
+
+static void R_GLStateBlendFunc(u32 src, u32 dst) {
+	if (_gl_state.blend_src == src && _gl_state.blend_dst == dst) {
+		_gl_state.stats.skipped++;
+		return;
+	}
+	_gl_state.blend_src = src;
+	_gl_state.blend_dst = dst;
+	_gl_state.stats.issued++;
+	glBlendFunc(src, dst);
+}
+
+static void R_GLStateScissorRect(i32 x, i32 y, i32 w, i32 h) {
+	i32* r = _gl_state.scissor_rect;
+	if (r[0] == x && r[1] == y && r[2] == w && r[3] == h) {
+		_gl_state.stats.skipped++;
+		return;
+	}
+	r[0] = x; r[1] = y; r[2] = w; r[3] = h;
+	_gl_state.stats.issued++;
+	glScissor(x, y, w, h);
+}
+
+static void R_GLStateCullFace(u32 face) {
+	if (R_GLStateChanged(&_gl_state.cull_face, face)) glCullFace(face);
+}
+
+// Deleted names can be handed out again, so anything still pointing at one has to be re-issued
+static void R_GLStateForget(u32* cached, u32 handle) {
+	if (*cached == handle) *cached = R_GL_UNKNOWN;
+}
+
+static void R_GLStateForgetTexture(u32 handle) {
+	for (u32 i = 0; i < R_GL_TEXTURE_SLOTS; i++)
+		R_GLStateForget(&_gl_state.textures[i], handle);
+}
+
+static void R_GLStateInvalidate(void) {
+	R_StateStats stats = _gl_state.stats;
+	memset(&_gl_state, 0xFF, sizeof(R_GLState));
+	_gl_state.stats = stats;
+}
+
+#endif //GL_STATE_H
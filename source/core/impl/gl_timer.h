@@ -0,0 +1,120 @@
+/* date = October 19th 2026 5:30 pm */
+
+#ifndef GL_TIMER_H
+#define GL_TIMER_H
+
+#include "gl_functions.h"
+
+// Every scope is a pair of GL_TIMESTAMP queries rather than a GL_TIME_ELAPSED one, elapsed queries can't nest.
+// Results are read R_GL_TIMER_FRAMES - 1 frames late, by which point they are almost always available
+#define R_GL_TIMER_FRAMES 3
+
+typedef struct R_GLTimerScope {
+	u8 name[R_GPU_TIMER_NAME_SIZE];
+	u32 name_size;
+	u32 depth;
+	u64 cpu_begin;
+	u64 cpu_end;
+} R_GLTimerScope;
+
+typedef struct R_GLTimerFrame {
+	R_GLTimerScope scopes[R_GPU_TIMER_MAX];
+	u32 queries[R_GPU_TIMER_MAX * 2];
+	u32 count;
+} R_GLTimerFrame;
+
+typedef struct R_GLTimers {
+	R_GLTimerFrame frames[R_GL_TIMER_FRAMES];
+	u32 current;
+	u32 stack[R_GPU_TIMER_MAX];
+	u32 depth;
+	b8 inited;
+	b8 queries;
+	b8 markers;
+	R_GpuReport report;
+} R_GLTimers;
+
+static R_GLTimers _gl_timers = {0};
+
+static void R_GLTimersInit(void) {
+	_gl_timers.inited = true;
+	_gl_timers.queries = glGenQueries && glQueryCounter && glGetQueryObjectiv && glGetQueryObjectui64v;
+	_gl_timers.markers = glPushDebugGroup && glPopDebugGroup;
+	if (!_gl_timers.queries) return;
+	for (u32 i = 0; i < R_GL_TIMER_FRAMES; i++)
+		glGenQueries(R_GPU_TIMER_MAX * 2, _gl_timers.frames[i].queries);
+}
+
+static void R_GLTimersResolve(R_GLTimerFrame* frame) {
+	if (!frame->count) return;
+
+	b8 gpu_timed = _gl_timers.queries;
+	if (gpu_timed) {
+		i32 available = 0;
+		glGetQueryObjectiv(frame->queries[frame->count * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+		// Reading now would stall on the GPU, keep showing the previous report instead
+		if (!available) return;
+	}
+
+	R_GpuReport* report = &_gl_timers.report;
+	report->count = frame->count;
+	report->gpu_timed = gpu_timed;
+	for (u32 i = 0; i < frame->count; i++) {
+		R_GLTimerScope* scope = &frame->scopes[i];
+		R_GpuTiming* timing = &report->timings[i];
+		memcpy(timing->name, scope->name, scope->name_size);
+		timing->name_size = scope->name_size;
+		timing->depth = scope->depth;
+		timing->cpu_ms = (scope->cpu_end - scope->cpu_begin) / 1000.0;
+		timing->gpu_ms = timing->cpu_ms;
+		if (gpu_timed) {
+			u64 begin = 0, end = 0;
+			glGetQueryObjectui64v(frame->queries[i * 2], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(frame->queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+			timing->gpu_ms = (end - begin) / 1000000.0;
+		}
+	}
+}
+
+static void R_GLTimerBegin(string name) {
+	if (!_gl_timers.inited) R_GLTimersInit();
+	if (_gl_timers.markers)
+		glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, name.size, (const GLchar*) name.str);
+
+	R_GLTimerFrame* frame = &_gl_timers.frames[_gl_timers.current];
+	// Scopes past the cap still have to pop, they just don't get timed
+	u32 index = frame->count < R_GPU_TIMER_MAX ? frame->count++ : R_GPU_TIMER_MAX;
+	if (_gl_timers.depth < R_GPU_TIMER_MAX) _gl_timers.stack[_gl_timers.depth] = index;
+	_gl_timers.depth++;
+	if (index == R_GPU_TIMER_MAX) return;
+
+	R_GLTimerScope* scope = &frame->scopes[index];
+	scope->name_size = Min(name.size, R_GPU_TIMER_NAME_SIZE);
+	memcpy(scope->name, name.str, scope->name_size);
+	scope->depth = _gl_timers.depth - 1;
+	scope->cpu_begin = OS_TimeMicrosecondsNow();
+	if (_gl_timers.queries) glQueryCounter(frame->queries[index * 2], GL_TIMESTAMP);
+}
+
+static void R_GLTimerEnd(void) {
+	if (!_gl_timers.depth) return;
+	_gl_timers.depth--;
+	if (_gl_timers.markers) glPopDebugGroup();
+	if (_gl_timers.depth >= R_GPU_TIMER_MAX) return;
+
+	u32 index = _gl_timers.stack[_gl_timers.depth];
+	if (index == R_GPU_TIMER_MAX) return;
+	R_GLTimerFrame* frame = &_gl_timers.frames[_gl_timers.current];
+	frame->scopes[index].cpu_end = OS_TimeMicrosecondsNow();
+	if (_gl_timers.queries) glQueryCounter(frame->queries[index * 2 + 1], GL_TIMESTAMP);
+}
+
+static void R_GLTimerFrameEnd(void) {
+	if (!_gl_timers.inited) return;
+	_gl_timers.current = (_gl_timers.current + 1) % R_GL_TIMER_FRAMES;
+	R_GLTimerFrame* oldest = &_gl_timers.frames[_gl_timers.current];
+	R_GLTimersResolve(oldest);
+	oldest->count = 0;
+}
+
+#endif //GL_TIMER_H
@@ -0,0 +1,202 @@
+/* date = October 19th 2026 6:20 pm */
+
+#ifndef RESOURCE_REGISTRY_H
+#define RESOURCE_REGISTRY_H
+
+// Every live backend object keyed by its type and GL name, with its size and where it was created.
+// Shader packs can share a cached program, so entries are refcounted rather than assumed unique
+#define R_REGISTRY_LIVE 1
+#define R_REGISTRY_TOMB 2
+
+typedef struct R_RegistrySite {
+	const char* file;
+	u32 line;
+} R_RegistrySite;
+
+typedef struct R_RegistryEntry {
+	u32 state;
+	u32 refs;
+	u64 bytes;
+	R_RegistrySite site;
+
+	u64 last_used;
+	R_TextureEvictFunc* evict;
+	void* user;
+} R_RegistryEntry;
+
+HashTable_Prototype(registry, u64, R_RegistryEntry);
+b8 registry_key_is_null(u64 k)  { return k == 0; }
+b8 registry_key_eq(u64 a, u64 b) { return a == b; }
+u64 registry_key_hash(u64 k)    { return U_HashBytes(U_HASH_SEED, &k, sizeof(u64)); }
+b8 registry_is_null(R_RegistryEntry e) { return e.state == 0; }
+b8 registry_is_tomb(R_RegistryEntry e) { return e.state == R_REGISTRY_TOMB; }
+HashTable_Impl(registry, registry_key_is_null, registry_key_eq, registry_key_hash, { .state = R_REGISTRY_TOMB }, registry_is_null, registry_is_tomb);
+
+typedef struct R_Registry {
+	registry_hash_table entries;
+	R_ResourceUsage usage;
+	// Set by the allocator macros, consumed by the next add
+	R_RegistrySite site;
+	u64 frame;
+	u64 texture_budget;
+} R_Registry;
+
+static R_Registry _registry = {0};
+
+static const char* r_resource_type_names[ResourceType_MAX] = {
+	"Buffer", "ShaderPack", "Pipeline", "Texture2D", "Framebuffer",
+};
+
+static u64 R_RegistryKey(R_ResourceType type, u32 handle) {
+	return ((u64) (type + 1) << 32) | handle;
+}
+
+static R_RegistrySite R_RegistryTakeSite(void) {
+	R_RegistrySite site = _registry.site;
+	_registry.site = (R_RegistrySite) {0};
+	return site;
+}
+
+static void R_RegistryAdd(R_ResourceType type, u32 handle, u64 bytes) {
+	R_RegistrySite site = R_RegistryTakeSite();
+	if (!handle) return;
+
+	R_RegistryEntry* entry;
+	if (registry_hash_table_get_ptr(&_registry.entries, R_RegistryKey(type, handle), &entry)) {
+		entry->refs++;
+		return;
+	}
+
+	R_RegistryEntry added = {
+		.state = R_REGISTRY_LIVE,
+		.refs = 1,
+		.bytes = bytes,
+		.site = site,
+		.last_used = _registry.frame,
+	};
+	registry_hash_table_set(&_registry.entries, R_RegistryKey(type, handle), added);
+	_registry.usage.count[type]++;
+	_registry.usage.bytes[type] += bytes;
+}
+
+static void R_RegistryResize(R_ResourceType type, u32 handle, u64 bytes) {
+	R_RegistryEntry* entry;
+	if (!registry_hash_table_get_ptr(&_registry.entries, R_RegistryKey(type, handle), &entry)) return;
+	_registry.usage.bytes[type] += bytes - entry->bytes;
+	entry->bytes = bytes;
+}
+
+static void R_RegistryRemove(R_ResourceType type, u32 handle) {
+	if (!handle) return;
+	R_RegistryEntry* entry;
+	if (!registry_hash_table_get_ptr(&_registry.entries, R_RegistryKey(type, handle), &entry)) {
+		LogError("Freeing %s %u which isn't alive, freed twice?", r_resource_type_names[type], handle);
+		return;
+	}
+	if (--entry->refs) return;
+
+	_registry.usage.count[type]--;
+	_registry.usage.bytes[type] -= entry->bytes;
+	registry_hash_table_del(&_registry.entries, R_RegistryKey(type, handle));
+}
+
+static void R_RegistryTouch(R_ResourceType type, u32 handle) {
+	R_RegistryEntry* entry;
+	if (registry_hash_table_get_ptr(&_registry.entries, R_RegistryKey(type, handle), &entry))
+		entry->last_used = _registry.frame;
+}
+
+// For objects that get recreated in place, like framebuffers on resize
+static R_RegistrySite R_RegistrySiteOf(R_ResourceType type, u32 handle) {
+	R_RegistryEntry entry = {0};
+	registry_hash_table_get(&_registry.entries, R_RegistryKey(type, handle), &entry);
+	return entry.site;
+}
+
+static void R_RegistrySiteSet(R_RegistrySite site) {
+	_registry.site = site;
+}
+
+static void R_RegistrySetEvict(R_ResourceType type, u32 handle, R_TextureEvictFunc* evict, void* user) {
+	R_RegistryEntry* entry;
+	if (!registry_hash_table_get_ptr(&_registry.entries, R_RegistryKey(type, handle), &entry)) return;
+	entry->evict = evict;
+	entry->user = user;
+}
+
+// Carries the eviction hook over when an object is swapped for a new one, like an async load finishing
+static void R_RegistryTransfer(R_ResourceType type, u32 from, u32 to) {
+	R_RegistryEntry* src;
+	R_RegistryEntry* dst;
+	if (!registry_hash_table_get_ptr(&_registry.entries, R_RegistryKey(type, from), &src)) return;
+	if (!registry_hash_table_get_ptr(&_registry.entries, R_RegistryKey(type, to), &dst)) return;
+	dst->evict = src->evict;
+	dst->user = src->user;
+	dst->last_used = src->last_used;
+}
+
+static u64 R_RegistryTextureBytes(R_TextureFormat format, u32 width, u32 height, R_TextureResizeParam min) {
+	u64 bpp = 4;
+	if (format == TextureFormat_R) bpp = 1;
+	else if (format == TextureFormat_RG) bpp = 2;
+	// RGB is padded out to 4 bytes by most drivers, integer and depth/stencil formats are 4 as well
+	u64 bytes = (u64) width * height * bpp;
+	if (min >= TextureResize_LinearMipmapLinear) bytes = bytes * 4 / 3;
+	return bytes;
+}
+
+//~ Public
+
+void R_ResourceSite(const char* file, u32 line) {
+	_registry.site = (R_RegistrySite) { file, line };
+}
+
+R_ResourceUsage R_ResourceUsageGet(void) {
+	return _registry.usage;
+}
+
+u32 R_ResourceReportLeaks(void) {
+	u32 leaks = 0;
+	for (u32 i = 0; i < _registry.entries.cap; i++) {
+		registry_hash_table_entry* e = &_registry.entries.elems[i];
+		if (registry_key_is_null(e->key)) continue;
+
+		R_ResourceType type = (R_ResourceType) ((e->key >> 32) - 1);
+		const char* file = e->value.site.file ? e->value.site.file : "unknown";
+		LogError("Leaked %s %u (%llu bytes) created at %s:%u", r_resource_type_names[type],
+				 (u32) e->key, e->value.bytes, file, e->value.site.line);
+		leaks++;
+	}
+	if (leaks) LogError("%u leaked render resources", leaks);
+	return leaks;
+}
+
+void R_TextureBudgetSet(u64 bytes) {
+	_registry.texture_budget = bytes;
+}
+
+void R_ResourceFrameEnd(void) {
+	u64 budget = _registry.texture_budget;
+	while (budget && _registry.usage.bytes[ResourceType_Texture2D] > budget) {
+		// Least recently bound first, and never something drawn with this frame
+		registry_hash_table_entry* victim = nullptr;
+		for (u32 i = 0; i < _registry.entries.cap; i++) {
+			registry_hash_table_entry* e = &_registry.entries.elems[i];
+			if (registry_key_is_null(e->key) || !e->value.evict) continue;
+			if ((e->key >> 32) - 1 != ResourceType_Texture2D) continue;
+			if (e->value.last_used >= _registry.frame) continue;
+			if (!victim || e->value.last_used < victim->value.last_used) victim = e;
+		}
+		if (!victim) break;
+
+		// The hook frees, and maybe reallocates, so nothing in the table can be held across it
+		R_TextureEvictFunc* evict = victim->value.evict;
+		void* user = victim->value.user;
+		victim->value.evict = nullptr;
+		evict(user);
+	}
+	R_RenderTargetsTrim();
+	_registry.frame++;
+}
+
+#endif //RESOURCE_REGISTRY_H
@@ -76,6 +76,7 @@ typedef PROC  WINAPI W32_wglGetProcAddress(LPCSTR);
 typedef BOOL WINAPI W32_wglChoosePixelFormatARB(HDC hdc, const int* piAttribIList, const FLOAT* pfAttribFList, UINT nMaxFormats, int* piFormats, UINT* nNumFormats);
 typedef HGLRC WINAPI W32_wglCreateContextAttribsARB(HDC hdc, HGLRC hShareContext, const int* attribList);
 typedef BOOL WINAPI W32_wglSwapLayerBuffers(HDC hdc, UINT plane);
+typedef BOOL WINAPI W32_wglGetPixelFormatAttribivARB(HDC hdc, int iPixelFormat, int iLayerPlane, UINT nAttributes, const int* piAttributes, int* piValues);
 
 static HMODULE opengl_module;
 
@@ -86,6 +87,7 @@ static W32_wglMakeCurrent* v_wglMakeCurrent;
 static W32_wglGetProcAddress* v_wglGetProcAddress;
 static W32_wglChoosePixelFormatARB* v_wglChoosePixelFormatARB;
 static W32_wglCreateContextAttribsARB* v_wglCreateContextAttribsARB;
+static W32_wglGetPixelFormatAttribivARB* v_wglGetPixelFormatAttribivARB;
 
 long_func* _GetAddress(const char* name) {
 	return (long_func*) GetProcAddress(opengl_module, name);
@@ -204,6 +206,8 @@ void B_BackendInitShared(OS_Window* _window, OS_Window* _share) {
 			ReleaseDC(bootstrap_window, dc);
 			LogReturn(, "Win32 OpenGL WGL Function Loading: Loading wglCreateContextAttribsARB failed");
 		}
+		// Optional, without it the swap method is unknown and every frame is redrawn in full
+		v_wglGetPixelFormatAttribivARB = (W32_wglGetPixelFormatAttribivARB*) v_wglGetProcAddress("wglGetPixelFormatAttribivARB");
 		
 		//- Delete Bootstrapping Stuff 
 		v_wglMakeCurrent(dc, 0);
@@ -229,12 +233,19 @@ void B_BackendInitShared(OS_Window* _window, OS_Window* _share) {
 		WGL_COLOR_BITS_ARB,         32,
 		WGL_DEPTH_BITS_ARB,         24,
 		WGL_STENCIL_BITS_ARB,       8,
+		// Copy swaps keep the back buffer intact, which partial repaints rely on. Asked for first
+		// and dropped if the driver has no such format, the swap method is the last pair
+		WGL_SWAP_METHOD_ARB,        WGL_SWAP_COPY_ARB,
 		0
 	};
 	
 	int format_idx;
-	UINT num_formats;
+	UINT num_formats = 0;
 	v_wglChoosePixelFormatARB(dc, format_attribs_i, 0, 1, &format_idx, &num_formats);
+	if (!num_formats) {
+		format_attribs_i[ArrayCount(format_attribs_i) - 3] = 0;
+		v_wglChoosePixelFormatARB(dc, format_attribs_i, 0, 1, &format_idx, &num_formats);
+	}
 	if (!num_formats) {
 		ReleaseDC(window->handle, dc);
 		LogReturn(, "Win32 OpenGL Window: Context Choosing Pixel Format failed");
@@ -268,6 +279,7 @@ void B_BackendInitShared(OS_Window* _window, OS_Window* _share) {
 		}
 		
 		__LoadGLFunctions(v_wglGetProcAddress, _GetAddress);
+		R_StateInvalidate();
 	}
 	
 	ReleaseDC(window->handle, dc);
@@ -282,6 +294,8 @@ void B_BackendSelectRenderWindow(OS_Window* _window) {
 	W32_Window* window = (W32_Window*) _window;
 	HDC dc = GetDC(window->handle);
 	v_wglMakeCurrent(dc, window->glrc);
+	// Every context has its own state
+	R_StateInvalidate();
 	glViewport(0, 0, window->width, window->height);
 	ReleaseDC(window->handle, dc);
 }
@@ -294,8 +308,21 @@ void B_BackendSwapchainNext(OS_Window* _window) {
 	glFlush();
 }
 
+b8 B_BackendSwapPreservesContents(OS_Window* _window) {
+	W32_Window* window = (W32_Window*) _window;
+	if (!v_wglGetPixelFormatAttribivARB) return false;
+	HDC dc = GetDC(window->handle);
+	int attrib = WGL_SWAP_METHOD_ARB;
+	int method = WGL_SWAP_UNDEFINED_ARB;
+	if (!v_wglGetPixelFormatAttribivARB(dc, GetPixelFormat(dc), 0, 1, &attrib, &method)) method = WGL_SWAP_UNDEFINED_ARB;
+	ReleaseDC(window->handle, dc);
+	return method == WGL_SWAP_COPY_ARB;
+}
+
 void B_BackendFree(OS_Window* _window) {
 	W32_Window* window = (W32_Window*) _window;
+	// Everything should be freed by now, whatever is left gets logged with where it was created
+	R_ResourceReportLeaks();
 	HDC dc = GetDC(window->handle);
 	v_wglMakeCurrent(dc, 0);
 	v_wglDeleteContext(window->glrc);
@@ -0,0 +1,188 @@
+#include "jobs.h"
+
+typedef struct J_Job {
+	J_JobFunc* func;
+	void* context;
+	u32 index;
+	J_Group* group;
+} J_Job;
+
+// A thread blocked in J_Wait, woken through its own semaphore when group finishes
+typedef struct J_Waiter {
+	J_Group* group;
+	OS_Semaphore wake;
+} J_Waiter;
+
+typedef struct J_Pool {
+	J_Job jobs[J_QUEUE_SIZE];
+	u32 head;
+	u32 tail;
+	OS_Mutex lock;
+	OS_Semaphore wake;
+	// Guarded by lock. Jobs wait on groups from workers too, so every waiter gets its own slot
+	// rather than sharing one semaphore, where one could take the wakeup meant for another
+	J_Waiter waiters[J_MAX_WAITERS];
+	
+	OS_Thread workers[J_MAX_WORKERS];
+	u32 worker_count;
+	volatile i32 quit;
+	b8 inited;
+} J_Pool;
+
+static J_Pool _jobs = {0};
+
+static b8 J_Take(J_Job* job) {
+	OS_MutexLock(&_jobs.lock);
+	b8 found = _jobs.head != _jobs.tail;
+	if (found) *job = _jobs.jobs[_jobs.head++ % J_QUEUE_SIZE];
+	OS_MutexUnlock(&_jobs.lock);
+	return found;
+}
+
+// Only takes jobs of group, so a waiter never ends up running something long it didn't ask for.
+// Run order is unspecified anyway, so the match is swapped to the head and taken from there
+static b8 J_TakeFromGroup(J_Group* group, J_Job* job) {
+	OS_MutexLock(&_jobs.lock);
+	b8 found = false;
+	for (u32 i = _jobs.head; i != _jobs.tail; i++) {
+		J_Job* candidate = &_jobs.jobs[i % J_QUEUE_SIZE];
+		if (candidate->group != group) continue;
+		*job = *candidate;
+		*candidate = _jobs.jobs[_jobs.head % J_QUEUE_SIZE];
+		_jobs.head++;
+		found = true;
+		break;
+	}
+	OS_MutexUnlock(&_jobs.lock);
+	return found;
+}
+
+static void J_Run(J_Job* job) {
+	job->func(job->context, job->index);
+	// Full barrier, everything the job wrote is visible once pending reads zero.
+	// A waiter registers under the lock before it checks pending, so either it sees zero or it gets woken.
+	// The group may already be gone by the time the lock is held, so it's only compared, never read
+	J_Group* group = job->group;
+	if (OS_AtomicDecrement(&group->pending) == 0 && _jobs.inited) {
+		OS_MutexLock(&_jobs.lock);
+		for (u32 i = 0; i < J_MAX_WAITERS; i++) {
+			if (_jobs.waiters[i].group == group) OS_SemaphoreSignal(&_jobs.waiters[i].wake, 1);
+		}
+		OS_MutexUnlock(&_jobs.lock);
+	}
+}
+
+static u32 J_WorkerMain(void* context) {
+	ThreadContext tctx = {0};
+	tctx_init(&tctx);
+	
+	while (true) {
+		OS_SemaphoreWait(&_jobs.wake);
+		if (_jobs.quit) break;
+		J_Job job;
+		if (J_Take(&job)) J_Run(&job);
+	}
+	
+	tctx_free(&tctx);
+	return 0;
+}
+
+void J_Init(u32 worker_count) {
+	if (_jobs.inited) return;
+	if (!worker_count) {
+		u32 cores = OS_ProcessorCount();
+		worker_count = cores > 1 ? cores - 1 : 1;
+	}
+	worker_count = Min(worker_count, J_MAX_WORKERS);
+	
+	OS_MutexInit(&_jobs.lock);
+	_jobs.wake = OS_SemaphoreCreate(0, J_QUEUE_SIZE + J_MAX_WORKERS);
+	for (u32 i = 0; i < J_MAX_WAITERS; i++) {
+		_jobs.waiters[i].group = nullptr;
+		_jobs.waiters[i].wake = OS_SemaphoreCreate(0, J_QUEUE_SIZE);
+	}
+	_jobs.worker_count = worker_count;
+	_jobs.quit = false;
+	for (u32 i = 0; i < worker_count; i++)
+		_jobs.workers[i] = OS_ThreadCreate(J_WorkerMain, nullptr);
+	_jobs.inited = true;
+}
+
+void J_Shutdown(void) {
+	if (!_jobs.inited) return;
+	_jobs.quit = true;
+	// The wake count can already be at its max from jobs that waiters took themselves, in which
+	// case a signal is dropped. Keep nudging until every worker has seen quit rather than trusting one
+	for (u32 i = 0; i < _jobs.worker_count; i++) {
+		while (!OS_ThreadIsDone(&_jobs.workers[i])) {
+			OS_SemaphoreSignal(&_jobs.wake, 1);
+			OS_TimeSleepMilliseconds(1);
+		}
+		OS_ThreadRelease(&_jobs.workers[i]);
+	}
+	OS_SemaphoreRelease(&_jobs.wake);
+	for (u32 i = 0; i < J_MAX_WAITERS; i++)
+		OS_SemaphoreRelease(&_jobs.waiters[i].wake);
+	_jobs.head = _jobs.tail = 0;
+	_jobs.inited = false;
+}
+
+u32 J_WorkerCount(void) {
+	return _jobs.inited ? _jobs.worker_count : 0;
+}
+
+void J_Dispatch(J_Group* group, J_JobFunc* func, void* context, u32 count) {
+	for (u32 i = 0; i < count; i++) {
+		J_Job job = { func, context, i, group };
+		OS_AtomicIncrement(&group->pending);
+		
+		b8 queued = false;
+		if (_jobs.inited) {
+			OS_MutexLock(&_jobs.lock);
+			if (_jobs.tail - _jobs.head < J_QUEUE_SIZE) {
+				_jobs.jobs[_jobs.tail++ % J_QUEUE_SIZE] = job;
+				queued = true;
+			}
+			OS_MutexUnlock(&_jobs.lock);
+		}
+		
+		// A full queue, or no pool at all, runs the job right here instead
+		if (queued) OS_SemaphoreSignal(&_jobs.wake, 1);
+		else J_Run(&job);
+	}
+}
+
+b8 J_IsDone(J_Group* group) {
+	return group->pending == 0;
+}
+
+void J_Wait(J_Group* group) {
+	while (group->pending > 0) {
+		J_Job job;
+		if (J_TakeFromGroup(group, &job)) {
+			J_Run(&job);
+			continue;
+		}
+		
+		// The rest is running on workers, sleep until the group finishes
+		J_Waiter* waiter = nullptr;
+		OS_MutexLock(&_jobs.lock);
+		for (u32 i = 0; i < J_MAX_WAITERS && !waiter; i++) {
+			if (!_jobs.waiters[i].group) waiter = &_jobs.waiters[i];
+		}
+		if (waiter) waiter->group = group;
+		OS_MutexUnlock(&_jobs.lock);
+		
+		// Every slot taken, only possible with more waiting threads than J_MAX_WAITERS
+		if (!waiter) {
+			OS_TimeSleepMilliseconds(1);
+			continue;
+		}
+		
+		// A wakeup left over from a wait that didn't block only costs one extra pass of this loop
+		if (group->pending > 0) OS_SemaphoreWait(&waiter->wake);
+		OS_MutexLock(&_jobs.lock);
+		waiter->group = nullptr;
+		OS_MutexUnlock(&_jobs.lock);
+	}
+}
@@ -0,0 +1,34 @@
+/* date = October 19th 2026 7:40 pm */
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "defines.h"
+#include "base/base.h"
+#include "os/os.h"
+
+#define J_QUEUE_SIZE 1024
+#define J_MAX_WORKERS 64
+// Threads that can block in J_Wait at once, every worker plus a few outside the pool
+#define J_MAX_WAITERS (J_MAX_WORKERS + 8)
+
+// index is the job's position within its dispatch, 0 to count - 1
+typedef void J_JobFunc(void* context, u32 index);
+
+// Jobs of one or more dispatches that haven't finished yet. Zero it before the first dispatch
+typedef struct J_Group {
+	volatile i32 pending;
+} J_Group;
+
+// 0 workers picks one per core besides the main thread. Without J_Init dispatches just run inline
+dll_plugin_api void J_Init(u32 worker_count);
+dll_plugin_api void J_Shutdown(void);
+dll_plugin_api u32  J_WorkerCount(void);
+
+// Queues count jobs and returns right away, run order across workers is unspecified
+dll_plugin_api void J_Dispatch(J_Group* group, J_JobFunc* func, void* context, u32 count);
+dll_plugin_api b8   J_IsDone(J_Group* group);
+// The calling thread runs the group's queued jobs itself, and sleeps once the rest are on workers
+dll_plugin_api void J_Wait(J_Group* group);
+
+#endif //JOBS_H
@@ -1,6 +1,14 @@
+// The allocators here are the real ones, not the call site recording macros
+#define R_RESOURCES_IMPL
 #include "resources.h"
 #include "base/base.h"
 #include "os/os.h"
+#include "frame.h"
+
+// Lives with the async loader below, the backend calls it when a texture is freed mid-load
+static void R_TextureLoadCancel(R_Texture2D* texture);
+// Lives with the render target pool, idle targets are trimmed as part of R_ResourceFrameEnd
+static void R_RenderTargetsTrim(void);
 
 #if defined(BACKEND_GL46)
 #  include "impl/gl46_resources.c"
@@ -13,3 +21,668 @@ void R_Texture2DWhite(R_Texture2D* texture) {
 	u8 data[] = { 255, 255, 255, 255 };
 	R_Texture2DData(texture, data);
 }
+
+//~ Async Texture Loading
+
+typedef struct R_TextureLoad {
+	R_Texture2D* target;
+	R_Texture2D texture;
+	string filepath;
+	R_TextureResizeParam min;
+	R_TextureResizeParam mag;
+	R_TextureWrapParam wrap_s;
+	R_TextureWrapParam wrap_t;
+	
+	OS_Thread thread;
+	b8 decoded;
+	b8 cancelled;
+	b8 failed;
+	
+	// From the header, read up front so the unpack buffer can be sized and mapped before the decode
+	i32 width;
+	i32 height;
+	i32 channels;
+	// The decode thread writes the image straight into the mapping, so the main thread never copies it
+	u32 pbo;
+	u8* mapped;
+	// Only when the buffer couldn't be mapped, rows are uploaded from the decoded pixels instead
+	u8* pixels;
+	
+	u64 row_size;
+	u32 rows_per_chunk;
+	u32 rows_uploaded;
+	b8 allocated;
+	R_RegistrySite site;
+} R_TextureLoad;
+
+Array_Prototype(R_TextureLoadArray, R_TextureLoad*);
+Array_Impl(R_TextureLoadArray, R_TextureLoad*);
+
+static R_TextureLoadArray r_texture_loads = {0};
+
+static u32 R_TextureLoadDecode(void* context) {
+	R_TextureLoad* load = (R_TextureLoad*) context;
+	stbi_set_flip_vertically_on_load_thread(R_GL_FLIP_ON_LOAD);
+	i32 width, height, channels;
+	u8* pixels = stbi_load((const char*) load->filepath.str, &width, &height, &channels, 0);
+	// The file can change between the header read and the decode
+	if (!pixels || width != load->width || height != load->height || channels != load->channels) {
+		if (pixels) stbi_image_free(pixels);
+		load->failed = true;
+		return 0;
+	}
+	
+	if (load->mapped) {
+		memcpy(load->mapped, pixels, load->row_size * load->height);
+		stbi_image_free(pixels);
+	} else {
+		load->pixels = pixels;
+	}
+	return 0;
+}
+
+// Frees everything except the uploaded texture, which is either swapped into the target or freed by the caller
+static void R_TextureLoadRelease(R_TextureLoad* load) {
+	if (load->pixels) stbi_image_free(load->pixels);
+	if (load->pbo) R_GLUnpackBufferFree(load->pbo);
+	free(load->filepath.str);
+	free(load);
+}
+
+static void R_TextureLoadCancel(R_Texture2D* texture) {
+	Iterate(r_texture_loads, i) {
+		R_TextureLoad* load = r_texture_loads.elems[i];
+		if (load->target == texture) {
+			load->target = nullptr;
+			load->cancelled = true;
+		}
+	}
+}
+
+void R_Texture2DAllocLoadAsync(R_Texture2D* texture, string filepath, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t) {
+	R_Texture2DWhite(texture);
+	
+	R_TextureLoad* load = calloc(1, sizeof(R_TextureLoad));
+	load->target = texture;
+	load->site = R_RegistrySiteOf(ResourceType_Texture2D, R_GLTexture2DHandle(texture));
+	load->filepath.str = calloc(filepath.size + 1, 1);
+	load->filepath.size = filepath.size;
+	memcpy(load->filepath.str, filepath.str, filepath.size);
+	load->min = min;
+	load->mag = mag;
+	load->wrap_s = wrap_s;
+	load->wrap_t = wrap_t;
+	
+	if (!stbi_info((const char*) load->filepath.str, &load->width, &load->height, &load->channels) ||
+		load->channels < 1 || load->channels > 4) {
+		LogError("Couldn't load texture '%.*s'", str_expand(filepath));
+		free(load->filepath.str);
+		free(load);
+		return;
+	}
+	load->row_size = (u64) load->width * load->channels;
+	load->pbo = R_GLUnpackBufferAlloc(load->row_size * load->height, (void**) &load->mapped);
+	if (!load->mapped) {
+		R_GLUnpackBufferFree(load->pbo);
+		load->pbo = 0;
+	}
+	
+	load->thread = OS_ThreadCreate(R_TextureLoadDecode, load);
+	R_TextureLoadArray_add(&r_texture_loads, load);
+}
+
+b8 R_Texture2DIsLoading(R_Texture2D* texture) {
+	Iterate(r_texture_loads, i) {
+		if (r_texture_loads.elems[i]->target == texture) return true;
+	}
+	return false;
+}
+
+void R_TextureLoadsPump(u64 budget) {
+	if (!r_texture_loads.len) return;
+	// Keep the loop ticking while decodes are in flight, the scheduler would otherwise sleep on input
+	F_RequestRedraw();
+	
+	R_TextureFormat formats[] = {
+		TextureFormat_Invalid, TextureFormat_R, TextureFormat_RG, TextureFormat_RGB, TextureFormat_RGBA
+	};
+	
+	for (i32 i = 0; i < r_texture_loads.len && budget; i++) {
+		R_TextureLoad* load = r_texture_loads.elems[i];
+		
+		if (!load->decoded) {
+			if (!OS_ThreadIsDone(&load->thread)) continue;
+			OS_ThreadRelease(&load->thread);
+			load->decoded = true;
+			if (!load->failed && load->pbo && !R_GLUnpackBufferFinish(load->pbo)) load->failed = true;
+			if (load->failed) LogError("Couldn't load texture '%.*s'", str_expand(load->filepath));
+		}
+		
+		if (load->cancelled || load->failed) {
+			if (load->allocated) R_Texture2DFree(&load->texture);
+			R_TextureLoadRelease(load);
+			R_TextureLoadArray_remove(&r_texture_loads, i--);
+			continue;
+		}
+		
+		if (!load->allocated) {
+			R_RegistrySiteSet(load->site);
+			R_Texture2DAlloc(&load->texture, formats[load->channels], load->width, load->height,
+							 load->min, load->mag, load->wrap_s, load->wrap_t);
+			load->rows_per_chunk = Min(Max(budget / load->row_size, 1), (u64) load->height);
+			load->allocated = true;
+		}
+		
+		while (budget && load->rows_uploaded < load->height) {
+			u32 rows = Min(load->rows_per_chunk, load->height - load->rows_uploaded);
+			u64 size = rows * load->row_size;
+			u64 offset = load->rows_uploaded * load->row_size;
+			R_GLTexture2DUploadRows(&load->texture, load->pbo, load->rows_uploaded, rows,
+									load->pbo ? (u8*) offset : load->pixels + offset);
+			load->rows_uploaded += rows;
+			budget = size >= budget ? 0 : budget - size;
+		}
+		
+		if (load->rows_uploaded == load->height) {
+			if (load->min >= TextureResize_LinearMipmapLinear)
+				R_GLTexture2DGenerateMipmaps(&load->texture);
+			
+			R_Texture2D placeholder = *load->target;
+			R_RegistryTransfer(ResourceType_Texture2D, R_GLTexture2DHandle(&placeholder), R_GLTexture2DHandle(&load->texture));
+			*load->target = load->texture;
+			load->target = nullptr;
+			R_Texture2DFree(&placeholder);
+			
+			R_TextureLoadRelease(load);
+			R_TextureLoadArray_remove(&r_texture_loads, i--);
+		}
+	}
+}
+
+//~ Render Target Pool
+
+typedef struct R_RenderTarget {
+	R_RenderTargetDesc desc;
+	R_Framebuffer framebuffer;
+	b8 in_use;
+	u64 released_frame;
+} R_RenderTarget;
+
+Array_Prototype(R_RenderTargetArray, R_RenderTarget*);
+Array_Impl(R_RenderTargetArray, R_RenderTarget*);
+
+static R_RenderTargetArray r_render_targets = {0};
+
+static void R_RenderTargetFree(R_RenderTarget* target) {
+	R_FramebufferFree(&target->framebuffer);
+	free(target);
+}
+
+R_Framebuffer* R_RenderTargetAcquire(R_RenderTargetDesc* desc) {
+	R_RegistrySite site = R_RegistryTakeSite();
+	
+	Iterate(r_render_targets, i) {
+		R_RenderTarget* target = r_render_targets.elems[i];
+		if (target->in_use || memcmp(&target->desc, desc, sizeof(R_RenderTargetDesc))) continue;
+		target->in_use = true;
+		return &target->framebuffer;
+	}
+	
+	R_RenderTarget* target = calloc(1, sizeof(R_RenderTarget));
+	target->desc = *desc;
+	target->in_use = true;
+	
+	u32 width = Max(desc->width, 1);
+	u32 height = Max(desc->height, 1);
+	R_Texture2D colors[R_RENDER_TARGET_MAX_COLOR] = {0};
+	u32 color_count = Min(desc->color_count, R_RENDER_TARGET_MAX_COLOR);
+	for (u32 i = 0; i < color_count; i++) {
+		R_RegistrySiteSet(site);
+		R_Texture2DAlloc(&colors[i], desc->color_formats[i], width, height, desc->filter, desc->filter, TextureWrap_ClampToEdge, TextureWrap_ClampToEdge);
+	}
+	R_Texture2D depth = {0};
+	if (desc->depth) {
+		R_RegistrySiteSet(site);
+		R_Texture2DAlloc(&depth, TextureFormat_DepthStencil, width, height, TextureResize_Nearest, TextureResize_Nearest, TextureWrap_ClampToEdge, TextureWrap_ClampToEdge);
+	}
+	R_RegistrySiteSet(site);
+	R_FramebufferCreate(&target->framebuffer, width, height, colors, color_count, depth);
+	
+	R_RenderTargetArray_add(&r_render_targets, target);
+	return &target->framebuffer;
+}
+
+void R_RenderTargetRelease(R_Framebuffer* framebuffer) {
+	Iterate(r_render_targets, i) {
+		R_RenderTarget* target = r_render_targets.elems[i];
+		if (&target->framebuffer != framebuffer) continue;
+		target->in_use = false;
+		target->released_frame = _registry.frame;
+		return;
+	}
+	LogError("Releasing a framebuffer that didn't come from R_RenderTargetAcquire");
+}
+
+void R_RenderTargetsFlush(void) {
+	for (i32 i = 0; i < r_render_targets.len; i++) {
+		R_RenderTarget* target = r_render_targets.elems[i];
+		if (target->in_use) continue;
+		R_RenderTargetFree(target);
+		R_RenderTargetArray_remove(&r_render_targets, i--);
+	}
+}
+
+static void R_RenderTargetsTrim(void) {
+	for (i32 i = 0; i < r_render_targets.len; i++) {
+		R_RenderTarget* target = r_render_targets.elems[i];
+		if (target->in_use || target->released_frame + R_RENDER_TARGET_IDLE_FRAMES > _registry.frame) continue;
+		R_RenderTargetFree(target);
+		R_RenderTargetArray_remove(&r_render_targets, i--);
+	}
+}
+
+//~ Frame Graph
+
+void R_FrameGraphBegin(R_FrameGraph* graph) {
+	MemoryZero(graph, sizeof(R_FrameGraph));
+	graph->target_count = 1;
+}
+
+R_GraphTarget R_FrameGraphTransient(R_FrameGraph* graph, R_RenderTargetDesc* desc) {
+	AssertTrue(graph->target_count < R_FRAME_GRAPH_MAX_TARGETS, "Too many frame graph targets");
+	R_GraphTargetSlot* slot = &graph->targets[graph->target_count];
+	slot->desc = *desc;
+	return graph->target_count++;
+}
+
+R_GraphTarget R_FrameGraphImport(R_FrameGraph* graph, R_Framebuffer* framebuffer) {
+	AssertTrue(graph->target_count < R_FRAME_GRAPH_MAX_TARGETS, "Too many frame graph targets");
+	R_GraphTargetSlot* slot = &graph->targets[graph->target_count];
+	slot->framebuffer = framebuffer;
+	slot->imported = true;
+	return graph->target_count++;
+}
+
+u32 R_FrameGraphPass(R_FrameGraph* graph, string name, R_GraphTarget output, R_GraphPassFunc* func, void* user) {
+	AssertTrue(graph->pass_count < R_FRAME_GRAPH_MAX_PASSES, "Too many frame graph passes");
+	R_GraphPass* pass = &graph->passes[graph->pass_count];
+	pass->name = name;
+	pass->func = func;
+	pass->user = user;
+	pass->output = output;
+	return graph->pass_count++;
+}
+
+void R_FrameGraphRead(R_FrameGraph* graph, u32 pass_index, R_GraphTarget input) {
+	R_GraphPass* pass = &graph->passes[pass_index];
+	AssertTrue(pass->input_count < R_FRAME_GRAPH_MAX_INPUTS, "Too many inputs for pass '%.*s'", str_expand(pass->name));
+	pass->inputs[pass->input_count++] = input;
+}
+
+void R_FrameGraphExecute(R_FrameGraph* graph) {
+	// Walk back from the screen and imported targets, anything not feeding into them is culled
+	b8 needed[R_FRAME_GRAPH_MAX_TARGETS] = {0};
+	b8 live[R_FRAME_GRAPH_MAX_PASSES] = {0};
+	needed[R_FRAME_GRAPH_SCREEN] = true;
+	for (u32 i = 0; i < graph->target_count; i++)
+		if (graph->targets[i].imported) needed[i] = true;
+	
+	for (i32 p = graph->pass_count - 1; p >= 0; p--) {
+		R_GraphPass* pass = &graph->passes[p];
+		if (!needed[pass->output]) continue;
+		live[p] = true;
+		for (u32 i = 0; i < pass->input_count; i++) needed[pass->inputs[i]] = true;
+	}
+	
+	for (u32 p = 0; p < graph->pass_count; p++) {
+		if (!live[p]) continue;
+		R_GraphPass* pass = &graph->passes[p];
+		graph->targets[pass->output].last_use = p;
+		for (u32 i = 0; i < pass->input_count; i++) graph->targets[pass->inputs[i]].last_use = p;
+	}
+	
+	for (u32 p = 0; p < graph->pass_count; p++) {
+		if (!live[p]) continue;
+		R_GraphPass* pass = &graph->passes[p];
+		
+		R_GraphTargetSlot* output = &graph->targets[pass->output];
+		if (pass->output != R_FRAME_GRAPH_SCREEN && !output->framebuffer)
+			output->framebuffer = R_RenderTargetAcquire(&output->desc);
+		
+		R_Framebuffer* inputs[R_FRAME_GRAPH_MAX_INPUTS] = {0};
+		for (u32 i = 0; i < pass->input_count; i++)
+			inputs[i] = graph->targets[pass->inputs[i]].framebuffer;
+		
+		R_GpuTimerBegin(pass->name);
+		if (output->framebuffer) R_FramebufferBind(output->framebuffer);
+		else R_FramebufferBindScreen();
+		pass->func(output->framebuffer, inputs, pass->input_count, pass->user);
+		R_GpuTimerEnd();
+		
+		// Back in the pool as soon as nothing else needs it, so a later pass can reuse the memory
+		for (u32 t = 1; t < graph->target_count; t++) {
+			R_GraphTargetSlot* slot = &graph->targets[t];
+			if (slot->imported || !slot->framebuffer || slot->last_use != p) continue;
+			R_RenderTargetRelease(slot->framebuffer);
+			slot->framebuffer = nullptr;
+		}
+	}
+}
+
+//~ Command Buffers
+
+#define R_COMMAND_BUFFER_SIZE Megabytes(64)
+
+typedef u32 R_CommandType;
+enum {
+	Command_PipelineBind,
+	Command_BufferUpdate,
+	Command_BufferBindUniform,
+	Command_UniformMat4,
+	Command_UniformInt,
+	Command_UniformIntArray,
+	Command_UniformFloat,
+	Command_UniformVec4,
+	Command_TextureBind,
+	Command_FramebufferBind,
+	Command_Clear,
+	Command_ClearColor,
+	Command_Viewport,
+	Command_ScissorEnable,
+	Command_ScissorDisable,
+	Command_BlendDisable,
+	Command_BlendAlpha,
+	Command_DepthEnable,
+	Command_DepthDisable,
+	Command_Cull,
+	Command_Draw,
+	Command_DrawIndexed,
+	Command_DrawInstanced,
+	Command_DrawIndexedInstanced,
+	Command_MultiDrawIndirect,
+	Command_TimerBegin,
+	Command_TimerEnd,
+	
+	Command_MAX,
+};
+
+// Every command is a header followed by its payload, padded so the next header stays 8 byte aligned.
+// Variable sized data (buffer contents, uniform arrays, names) directly follows the payload
+typedef struct R_CommandHeader {
+	R_CommandType type;
+	u32 size;
+} R_CommandHeader;
+
+typedef struct R_CommandDraw {
+	R_Pipeline* pipeline;
+	u32 start;
+	u32 count;
+	u32 instance_count;
+} R_CommandDraw;
+
+typedef struct R_CommandTexture {
+	R_Texture2D* texture;
+	u32 slot;
+} R_CommandTexture;
+
+typedef struct R_CommandBufferData {
+	R_Buffer* buffer;
+	u64 offset;
+	u64 size;
+} R_CommandBufferData;
+
+typedef struct R_CommandUniform {
+	R_Uniform uniform;
+	union {
+		mat4 mat;
+		vec4 vec;
+		i32 i;
+		f32 f;
+		u32 count;
+	};
+} R_CommandUniform;
+
+typedef struct R_CommandRect {
+	i32 x, y, w, h;
+} R_CommandRect;
+
+static void* R_CommandPush(R_CommandBuffer* cmd, R_CommandType type, u64 payload_size, u64 extra_size) {
+	if (!cmd->inited) {
+		arena_init_sized(&cmd->arena, R_COMMAND_BUFFER_SIZE);
+		cmd->inited = true;
+	}
+	u64 size = (sizeof(R_CommandHeader) + payload_size + extra_size + 7) & ~7ull;
+	R_CommandHeader* header = arena_alloc(&cmd->arena, size);
+	header->type = type;
+	header->size = (u32) size;
+	cmd->count++;
+	return header + 1;
+}
+
+void R_CommandBufferReset(R_CommandBuffer* cmd) {
+	if (!cmd->inited) return;
+	arena_clear(&cmd->arena);
+	cmd->count = 0;
+}
+
+void R_CommandBufferFree(R_CommandBuffer* cmd) {
+	if (!cmd->inited) return;
+	arena_free(&cmd->arena);
+	cmd->count = 0;
+	cmd->inited = false;
+}
+
+void R_CmdPipelineBind(R_CommandBuffer* cmd, R_Pipeline* pipeline) {
+	R_Pipeline** payload = R_CommandPush(cmd, Command_PipelineBind, sizeof(R_Pipeline*), 0);
+	*payload = pipeline;
+}
+
+void R_CmdBufferUpdate(R_CommandBuffer* cmd, R_Buffer* buffer, u64 offset, u64 size, void* data) {
+	R_CommandBufferData* payload = R_CommandPush(cmd, Command_BufferUpdate, sizeof(R_CommandBufferData), size);
+	payload->buffer = buffer;
+	payload->offset = offset;
+	payload->size = size;
+	memcpy(payload + 1, data, size);
+}
+
+void R_CmdBufferBindUniform(R_CommandBuffer* cmd, R_Buffer* buffer, u32 binding) {
+	R_CommandBufferData* payload = R_CommandPush(cmd, Command_BufferBindUniform, sizeof(R_CommandBufferData), 0);
+	payload->buffer = buffer;
+	payload->offset = binding;
+}
+
+void R_CmdUniformMat4(R_CommandBuffer* cmd, R_Uniform uniform, mat4 mat) {
+	R_CommandUniform* payload = R_CommandPush(cmd, Command_UniformMat4, sizeof(R_CommandUniform), 0);
+	payload->uniform = uniform;
+	payload->mat = mat;
+}
+
+void R_CmdUniformInt(R_CommandBuffer* cmd, R_Uniform uniform, i32 val) {
+	R_CommandUniform* payload = R_CommandPush(cmd, Command_UniformInt, sizeof(R_CommandUniform), 0);
+	payload->uniform = uniform;
+	payload->i = val;
+}
+
+void R_CmdUniformIntArray(R_CommandBuffer* cmd, R_Uniform uniform, i32* vals, u32 count) {
+	R_CommandUniform* payload = R_CommandPush(cmd, Command_UniformIntArray, sizeof(R_CommandUniform), sizeof(i32) * count);
+	payload->uniform = uniform;
+	payload->count = count;
+	memcpy(payload + 1, vals, sizeof(i32) * count);
+}
+
+void R_CmdUniformFloat(R_CommandBuffer* cmd, R_Uniform uniform, f32 val) {
+	R_CommandUniform* payload = R_CommandPush(cmd, Command_UniformFloat, sizeof(R_CommandUniform), 0);
+	payload->uniform = uniform;
+	payload->f = val;
+}
+
+void R_CmdUniformVec4(R_CommandBuffer* cmd, R_Uniform uniform, vec4 val) {
+	R_CommandUniform* payload = R_CommandPush(cmd, Command_UniformVec4, sizeof(R_CommandUniform), 0);
+	payload->uniform = uniform;
+	payload->vec = val;
+}
+
+void R_CmdTextureBind(R_CommandBuffer* cmd, R_Texture2D* texture, u32 slot) {
+	R_CommandTexture* payload = R_CommandPush(cmd, Command_TextureBind, sizeof(R_CommandTexture), 0);
+	payload->texture = texture;
+	payload->slot = slot;
+}
+
+void R_CmdFramebufferBind(R_CommandBuffer* cmd, R_Framebuffer* framebuffer) {
+	R_Framebuffer** payload = R_CommandPush(cmd, Command_FramebufferBind, sizeof(R_Framebuffer*), 0);
+	*payload = framebuffer;
+}
+
+void R_CmdClear(R_CommandBuffer* cmd, R_BufferMask buffer_mask) {
+	R_BufferMask* payload = R_CommandPush(cmd, Command_Clear, sizeof(R_BufferMask), 0);
+	*payload = buffer_mask;
+}
+
+void R_CmdClearColor(R_CommandBuffer* cmd, f32 r, f32 g, f32 b, f32 a) {
+	vec4* payload = R_CommandPush(cmd, Command_ClearColor, sizeof(vec4), 0);
+	*payload = vec4_init(r, g, b, a);
+}
+
+void R_CmdViewport(R_CommandBuffer* cmd, i32 x, i32 y, i32 w, i32 h) {
+	R_CommandRect* payload = R_CommandPush(cmd, Command_Viewport, sizeof(R_CommandRect), 0);
+	*payload = (R_CommandRect) { x, y, w, h };
+}
+
+void R_CmdScissorEnable(R_CommandBuffer* cmd, i32 x, i32 y, i32 w, i32 h) {
+	R_CommandRect* payload = R_CommandPush(cmd, Command_ScissorEnable, sizeof(R_CommandRect), 0);
+	*payload = (R_CommandRect) { x, y, w, h };
+}
+
+void R_CmdScissorDisable(R_CommandBuffer* cmd) { R_CommandPush(cmd, Command_ScissorDisable, 0, 0); }
+void R_CmdBlendDisable(R_CommandBuffer* cmd)   { R_CommandPush(cmd, Command_BlendDisable, 0, 0); }
+void R_CmdBlendAlpha(R_CommandBuffer* cmd)     { R_CommandPush(cmd, Command_BlendAlpha, 0, 0); }
+void R_CmdDepthEnable(R_CommandBuffer* cmd)    { R_CommandPush(cmd, Command_DepthEnable, 0, 0); }
+void R_CmdDepthDisable(R_CommandBuffer* cmd)   { R_CommandPush(cmd, Command_DepthDisable, 0, 0); }
+void R_CmdTimerEnd(R_CommandBuffer* cmd)       { R_CommandPush(cmd, Command_TimerEnd, 0, 0); }
+
+void R_CmdCull(R_CommandBuffer* cmd, R_CullFace to_cull) {
+	R_CullFace* payload = R_CommandPush(cmd, Command_Cull, sizeof(R_CullFace), 0);
+	*payload = to_cull;
+}
+
+static void R_CmdDrawGeneric(R_CommandBuffer* cmd, R_CommandType type, R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count) {
+	R_CommandDraw* payload = R_CommandPush(cmd, type, sizeof(R_CommandDraw), 0);
+	*payload = (R_CommandDraw) { pipeline, start, count, instance_count };
+}
+
+void R_CmdDraw(R_CommandBuffer* cmd, R_Pipeline* pipeline, u32 start, u32 count) {
+	R_CmdDrawGeneric(cmd, Command_Draw, pipeline, start, count, 1);
+}
+
+void R_CmdDrawIndexed(R_CommandBuffer* cmd, R_Pipeline* pipeline, u32 start, u32 count) {
+	R_CmdDrawGeneric(cmd, Command_DrawIndexed, pipeline, start, count, 1);
+}
+
+void R_CmdDrawInstanced(R_CommandBuffer* cmd, R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count) {
+	R_CmdDrawGeneric(cmd, Command_DrawInstanced, pipeline, start, count, instance_count);
+}
+
+void R_CmdDrawIndexedInstanced(R_CommandBuffer* cmd, R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count) {
+	R_CmdDrawGeneric(cmd, Command_DrawIndexedInstanced, pipeline, start, count, instance_count);
+}
+
+void R_CmdMultiDrawIndirect(R_CommandBuffer* cmd, R_Pipeline* pipeline, R_Buffer* commands, u32 draw_count) {
+	R_CommandDraw* payload = R_CommandPush(cmd, Command_MultiDrawIndirect, sizeof(R_CommandDraw) + sizeof(R_Buffer*), 0);
+	*payload = (R_CommandDraw) { pipeline, 0, draw_count, 0 };
+	*(R_Buffer**) (payload + 1) = commands;
+}
+
+void R_CmdTimerBegin(R_CommandBuffer* cmd, string name) {
+	u64* payload = R_CommandPush(cmd, Command_TimerBegin, sizeof(u64), name.size);
+	*payload = name.size;
+	memcpy(payload + 1, name.str, name.size);
+}
+
+static void R_CommandBufferExecute(R_CommandBuffer* cmd) {
+	u8* at = cmd->arena.memory;
+	for (u32 c = 0; c < cmd->count; c++) {
+		R_CommandHeader* header = (R_CommandHeader*) at;
+		void* payload = header + 1;
+		at += header->size;
+		
+		switch (header->type) {
+			case Command_PipelineBind: R_PipelineBind(*(R_Pipeline**) payload); break;
+			case Command_BufferUpdate: {
+				R_CommandBufferData* data = payload;
+				R_BufferUpdate(data->buffer, data->offset, data->size, data + 1);
+			} break;
+			case Command_BufferBindUniform: {
+				R_CommandBufferData* data = payload;
+				R_BufferBindUniform(data->buffer, (u32) data->offset);
+			} break;
+			case Command_UniformMat4:  R_UniformUploadMat4(((R_CommandUniform*) payload)->uniform, ((R_CommandUniform*) payload)->mat); break;
+			case Command_UniformInt:   R_UniformUploadInt(((R_CommandUniform*) payload)->uniform, ((R_CommandUniform*) payload)->i); break;
+			case Command_UniformFloat: R_UniformUploadFloat(((R_CommandUniform*) payload)->uniform, ((R_CommandUniform*) payload)->f); break;
+			case Command_UniformVec4:  R_UniformUploadVec4(((R_CommandUniform*) payload)->uniform, ((R_CommandUniform*) payload)->vec); break;
+			case Command_UniformIntArray: {
+				R_CommandUniform* u = payload;
+				R_UniformUploadIntArray(u->uniform, (i32*) (u + 1), u->count);
+			} break;
+			case Command_TextureBind: {
+				R_CommandTexture* bind = payload;
+				R_Texture2DBindTo(bind->texture, bind->slot);
+			} break;
+			case Command_FramebufferBind: {
+				R_Framebuffer* framebuffer = *(R_Framebuffer**) payload;
+				if (framebuffer) R_FramebufferBind(framebuffer);
+				else R_FramebufferBindScreen();
+			} break;
+			case Command_Clear: R_Clear(*(R_BufferMask*) payload); break;
+			case Command_ClearColor: {
+				vec4 c = *(vec4*) payload;
+				R_ClearColor(c.x, c.y, c.z, c.w);
+			} break;
+			case Command_Viewport: {
+				R_CommandRect* r = payload;
+				R_Viewport(r->x, r->y, r->w, r->h);
+			} break;
+			case Command_ScissorEnable: {
+				R_CommandRect* r = payload;
+				R_ScissorEnable(r->x, r->y, r->w, r->h);
+			} break;
+			case Command_ScissorDisable: R_ScissorDisable(); break;
+			case Command_BlendDisable: R_BlendDisable(); break;
+			case Command_BlendAlpha: R_BlendAlpha(); break;
+			case Command_DepthEnable: R_DepthEnable(); break;
+			case Command_DepthDisable: R_DepthDisable(); break;
+			case Command_Cull: R_Cull(*(R_CullFace*) payload); break;
+			case Command_Draw: {
+				R_CommandDraw* d = payload;
+				R_Draw(d->pipeline, d->start, d->count);
+			} break;
+			case Command_DrawIndexed: {
+				R_CommandDraw* d = payload;
+				R_DrawIndexed(d->pipeline, d->start, d->count);
+			} break;
+			case Command_DrawInstanced: {
+				R_CommandDraw* d = payload;
+				R_DrawInstanced(d->pipeline, d->start, d->count, d->instance_count);
+			} break;
+			case Command_DrawIndexedInstanced: {
+				R_CommandDraw* d = payload;
+				R_DrawIndexedInstanced(d->pipeline, d->start, d->count, d->instance_count);
+			} break;
+			case Command_MultiDrawIndirect: {
+				R_CommandDraw* d = payload;
+				R_MultiDrawIndirect(d->pipeline, *(R_Buffer**) (d + 1), d->count);
+			} break;
+			case Command_TimerBegin: {
+				u64 size = *(u64*) payload;
+				R_GpuTimerBegin((string) { .str = (u8*) payload + sizeof(u64), .size = size });
+			} break;
+			case Command_TimerEnd: R_GpuTimerEnd(); break;
+		}
+	}
+}
+
+void R_CommandBuffersSubmit(R_CommandBuffer* cmds, u32 count) {
+	for (u32 i = 0; i < count; i++) {
+		if (!cmds[i].inited) continue;
+		R_CommandBufferExecute(&cmds[i]);
+	}
+}
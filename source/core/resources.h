@@ -18,6 +18,7 @@ enum {
 	BufferFlag_Type_Vertex = 0x2,
 	BufferFlag_Type_Index = 0x4,
 	BufferFlag_Type_Uniform = 0x8,
+	BufferFlag_Type_Indirect = 0x10,
 };
 
 typedef struct R_Buffer {
@@ -29,6 +30,8 @@ dll_plugin_api void R_BufferAlloc(R_Buffer* buf, R_BufferFlags flags);
 dll_plugin_api void R_BufferData(R_Buffer* buf, u64 size, void* data);
 dll_plugin_api void R_BufferUpdate(R_Buffer* _buf, u64 offset, u64 size, void* data);
 dll_plugin_api void R_BufferFree(R_Buffer* buf);
+// Binds a BufferFlag_Type_Uniform buffer to a uniform block binding point
+dll_plugin_api void R_BufferBindUniform(R_Buffer* buf, u32 binding);
 
 //~ Shaders
 
@@ -50,6 +53,12 @@ typedef struct R_ShaderPack {
 	u64 v[4];
 } R_ShaderPack;
 
+// Pre-resolved uniform location. Resolve once after loading, upload by handle every draw.
+// Uploads go to the currently bound pipeline's shader, same as the name based ones
+typedef struct R_Uniform {
+	u64 v[1];
+} R_Uniform;
+
 dll_plugin_api void R_ShaderAlloc(R_Shader* shader, string data, R_ShaderType type);
 dll_plugin_api void R_ShaderAllocLoad(R_Shader* shader, string fp, R_ShaderType type);
 dll_plugin_api void R_ShaderFree(R_Shader* shader);
@@ -64,6 +73,15 @@ dll_plugin_api void R_ShaderPackUploadIntArray(R_ShaderPack* _pack, string name,
 dll_plugin_api void R_ShaderPackUploadFloat(R_ShaderPack* pack, string name, f32 val);
 dll_plugin_api void R_ShaderPackUploadVec4(R_ShaderPack* pack, string name, vec4 val);
 
+dll_plugin_api R_Uniform R_ShaderPackGetUniform(R_ShaderPack* pack, string name);
+dll_plugin_api void R_ShaderPackBindUniformBlock(R_ShaderPack* pack, string block, u32 binding);
+
+dll_plugin_api void R_UniformUploadMat4(R_Uniform uniform, mat4 mat);
+dll_plugin_api void R_UniformUploadInt(R_Uniform uniform, i32 val);
+dll_plugin_api void R_UniformUploadIntArray(R_Uniform uniform, i32* vals, u32 count);
+dll_plugin_api void R_UniformUploadFloat(R_Uniform uniform, f32 val);
+dll_plugin_api void R_UniformUploadVec4(R_Uniform uniform, vec4 val);
+
 //~ Pipelines (VAOs)
 
 typedef u32 R_InputAssembly;
@@ -99,6 +117,10 @@ typedef struct R_Pipeline {
 
 dll_plugin_api void R_PipelineAlloc(R_Pipeline* _in, R_InputAssembly assembly, R_Attribute* attributes, u32 attribute_count, R_ShaderPack* shader);
 dll_plugin_api void R_PipelineAddBuffer(R_Pipeline* in, R_Buffer* _buf, u32 attribute_count);
+// The buffer's attributes advance once every `divisor` instances instead of once per vertex
+dll_plugin_api void R_PipelineAddInstanceBuffer(R_Pipeline* in, R_Buffer* _buf, u32 attribute_count, u32 divisor);
+// u32 indices, read by the R_DrawIndexed* calls
+dll_plugin_api void R_PipelineSetIndexBuffer(R_Pipeline* in, R_Buffer* _buf);
 dll_plugin_api void R_PipelineBind(R_Pipeline* in);
 dll_plugin_api void R_PipelineFree(R_Pipeline* in);
 
@@ -175,6 +197,18 @@ dll_plugin_api b8   R_Texture2DEquals(R_Texture2D* a, R_Texture2D* b);
 dll_plugin_api void R_Texture2DBindTo(R_Texture2D* texture, u32 slot);
 dll_plugin_api void R_Texture2DFree(R_Texture2D* texture);
 
+//~ Async Texture Loading
+
+// Bytes of decoded pixels R_TextureLoadsPump uploads per frame
+#define R_TEXTURE_UPLOAD_BUDGET (4 * 1024 * 1024)
+
+// Decodes on a worker thread into a mapped unpack buffer, then uploads in row slices from it in R_TextureLoadsPump.
+// The texture is a 1x1 white placeholder until it is swapped in place, so it must stay at the same address.
+// Freeing it cancels the load. Mipmaps are generated when min is one of the mipmapped filters
+dll_plugin_api void R_Texture2DAllocLoadAsync(R_Texture2D* texture, string filepath, R_TextureResizeParam min, R_TextureResizeParam mag, R_TextureWrapParam wrap_s, R_TextureWrapParam wrap_t);
+dll_plugin_api b8   R_Texture2DIsLoading(R_Texture2D* texture);
+dll_plugin_api void R_TextureLoadsPump(u64 budget);
+
 //~ Framebuffer
 
 typedef struct R_Framebuffer {
@@ -192,11 +226,98 @@ dll_plugin_api void R_FramebufferCreate(R_Framebuffer* _framebuffer, u32 width,
 dll_plugin_api void R_FramebufferBind(R_Framebuffer* framebuffer);
 dll_plugin_api void R_FramebufferBindScreen(void);
 dll_plugin_api void R_FramebufferBlitToScreen(OS_Window* window, R_Framebuffer* framebuffer);
+// Blocks until the GPU has finished everything queued so far, R_FramebufferReadPixelAsync doesn't
 dll_plugin_api void R_FramebufferReadPixel(R_Framebuffer* _framebuffer, u32 attachment, u32 x, u32 y,
 										   void* data);
 dll_plugin_api void R_FramebufferResize(R_Framebuffer* framebuffer, u32 new_width, u32 new_height);
 dll_plugin_api void R_FramebufferFree(R_Framebuffer* framebuffer);
 
+//~ Readback
+
+// Reads go into a pixel pack buffer and are copied out once the GPU is past them, usually a frame or two later.
+// Poll once per frame, it returns true exactly once per request
+typedef struct R_Readback {
+	u64 v[3];
+} R_Readback;
+
+dll_plugin_api void R_ReadbackAlloc(R_Readback* readback, u64 size);
+dll_plugin_api void R_FramebufferReadRegionAsync(R_Readback* readback, R_Framebuffer* framebuffer, u32 attachment,
+												 u32 x, u32 y, u32 w, u32 h);
+dll_plugin_api void R_FramebufferReadPixelAsync(R_Readback* readback, R_Framebuffer* framebuffer, u32 attachment, u32 x, u32 y);
+dll_plugin_api b8   R_ReadbackIsPending(R_Readback* readback);
+dll_plugin_api b8   R_ReadbackPoll(R_Readback* readback, void* data);
+dll_plugin_api void R_ReadbackFree(R_Readback* readback);
+
+//~ Render Target Pool
+
+#define R_RENDER_TARGET_MAX_COLOR 4
+// Released targets nobody asks for again within this many frames are freed
+#define R_RENDER_TARGET_IDLE_FRAMES 120
+
+// Zero it before filling it in, targets are matched on the whole struct
+typedef struct R_RenderTargetDesc {
+	u32 width;
+	u32 height;
+	R_TextureFormat color_formats[R_RENDER_TARGET_MAX_COLOR];
+	u32 color_count;
+	b8 depth;
+	R_TextureResizeParam filter;
+} R_RenderTargetDesc;
+
+// Hands out a pooled framebuffer matching desc, creating one only when none is free.
+// The pointer stays valid until it is released, and R_FramebufferResize/Free must not be called on it
+dll_plugin_api R_Framebuffer* R_RenderTargetAcquire(R_RenderTargetDesc* desc);
+dll_plugin_api void R_RenderTargetRelease(R_Framebuffer* target);
+// Frees every released target right away, rather than waiting for them to go idle
+dll_plugin_api void R_RenderTargetsFlush(void);
+
+//~ Frame Graph
+
+#define R_FRAME_GRAPH_MAX_TARGETS 16
+#define R_FRAME_GRAPH_MAX_PASSES 16
+#define R_FRAME_GRAPH_MAX_INPUTS 4
+// Target 0 is always the screen
+#define R_FRAME_GRAPH_SCREEN 0
+
+typedef u32 R_GraphTarget;
+
+// inputs are in the order they were declared with R_FrameGraphRead. output is null for the screen
+typedef void R_GraphPassFunc(R_Framebuffer* output, R_Framebuffer** inputs, u32 input_count, void* user);
+
+typedef struct R_GraphPass {
+	string name;
+	R_GraphPassFunc* func;
+	void* user;
+	R_GraphTarget output;
+	R_GraphTarget inputs[R_FRAME_GRAPH_MAX_INPUTS];
+	u32 input_count;
+} R_GraphPass;
+
+typedef struct R_GraphTargetSlot {
+	R_RenderTargetDesc desc;
+	R_Framebuffer* framebuffer;
+	b8 imported;
+	u32 last_use;
+} R_GraphTargetSlot;
+
+// Passes run in the order they are added, and each one declares what it reads and writes.
+// Transient targets are taken from the pool right before their first pass and go back right after their last,
+// so passes later in the frame with the same desc share the memory. Passes nothing reads from are skipped
+typedef struct R_FrameGraph {
+	R_GraphTargetSlot targets[R_FRAME_GRAPH_MAX_TARGETS];
+	u32 target_count;
+	R_GraphPass passes[R_FRAME_GRAPH_MAX_PASSES];
+	u32 pass_count;
+} R_FrameGraph;
+
+dll_plugin_api void R_FrameGraphBegin(R_FrameGraph* graph);
+dll_plugin_api R_GraphTarget R_FrameGraphTransient(R_FrameGraph* graph, R_RenderTargetDesc* desc);
+// For targets that have to outlive the frame, they are never released by the graph
+dll_plugin_api R_GraphTarget R_FrameGraphImport(R_FrameGraph* graph, R_Framebuffer* framebuffer);
+dll_plugin_api u32  R_FrameGraphPass(R_FrameGraph* graph, string name, R_GraphTarget output, R_GraphPassFunc* func, void* user);
+dll_plugin_api void R_FrameGraphRead(R_FrameGraph* graph, u32 pass, R_GraphTarget input);
+dll_plugin_api void R_FrameGraphExecute(R_FrameGraph* graph);
+
 //~ Other
 
 typedef u32 R_BufferMask;
@@ -219,12 +340,164 @@ dll_plugin_api void R_ClearColor(f32 r, f32 g, f32 b, f32 a);
 
 // TODO(voxel): Move all this to pipelines
 dll_plugin_api void R_Viewport(i32 x, i32 y, i32 w, i32 h);
+dll_plugin_api void R_ScissorEnable(i32 x, i32 y, i32 w, i32 h);
+dll_plugin_api void R_ScissorDisable(void);
 dll_plugin_api void R_BlendDisable(void);
 dll_plugin_api void R_BlendAlpha(void);
 dll_plugin_api void R_DepthEnable(void);
 dll_plugin_api void R_DepthDisable(void);
 dll_plugin_api void R_Cull(R_CullFace to_cull);
 
+// Layout of one entry in a BufferFlag_Type_Indirect buffer
+typedef struct R_DrawIndirectCommand {
+	u32 count;
+	u32 instance_count;
+	u32 first;
+	u32 base_instance;
+} R_DrawIndirectCommand;
+
 dll_plugin_api void R_Draw(R_Pipeline* pipeline, u32 start, u32 count);
+dll_plugin_api void R_DrawIndexed(R_Pipeline* pipeline, u32 start, u32 count);
+dll_plugin_api void R_DrawInstanced(R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count);
+dll_plugin_api void R_DrawIndexedInstanced(R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count);
+// Single call on GL 4.6. The GL 3.3 backend loops over a CPU copy kept by R_BufferData/R_BufferUpdate, ignoring base_instance
+dll_plugin_api void R_MultiDrawIndirect(R_Pipeline* pipeline, R_Buffer* commands, u32 draw_count);
+
+//~ Command Buffers
+
+// Commands recorded into the buffer's own arena without touching GL, so any thread can record.
+// Submit replays them in order on the render thread. Resources are referenced rather than copied and
+// have to outlive the submit, buffer updates and uniform arrays are copied in.
+// Submitting doesn't reset, a recorded stream can be replayed as many times as needed
+typedef struct R_CommandBuffer {
+	M_Arena arena;
+	u32 count;
+	b8 inited;
+} R_CommandBuffer;
+
+dll_plugin_api void R_CommandBufferReset(R_CommandBuffer* cmd);
+dll_plugin_api void R_CommandBuffersSubmit(R_CommandBuffer* cmds, u32 count);
+dll_plugin_api void R_CommandBufferFree(R_CommandBuffer* cmd);
+
+dll_plugin_api void R_CmdPipelineBind(R_CommandBuffer* cmd, R_Pipeline* pipeline);
+dll_plugin_api void R_CmdBufferUpdate(R_CommandBuffer* cmd, R_Buffer* buffer, u64 offset, u64 size, void* data);
+dll_plugin_api void R_CmdBufferBindUniform(R_CommandBuffer* cmd, R_Buffer* buffer, u32 binding);
+dll_plugin_api void R_CmdUniformMat4(R_CommandBuffer* cmd, R_Uniform uniform, mat4 mat);
+dll_plugin_api void R_CmdUniformInt(R_CommandBuffer* cmd, R_Uniform uniform, i32 val);
+dll_plugin_api void R_CmdUniformIntArray(R_CommandBuffer* cmd, R_Uniform uniform, i32* vals, u32 count);
+dll_plugin_api void R_CmdUniformFloat(R_CommandBuffer* cmd, R_Uniform uniform, f32 val);
+dll_plugin_api void R_CmdUniformVec4(R_CommandBuffer* cmd, R_Uniform uniform, vec4 val);
+dll_plugin_api void R_CmdTextureBind(R_CommandBuffer* cmd, R_Texture2D* texture, u32 slot);
+// Null binds the screen
+dll_plugin_api void R_CmdFramebufferBind(R_CommandBuffer* cmd, R_Framebuffer* framebuffer);
+dll_plugin_api void R_CmdClear(R_CommandBuffer* cmd, R_BufferMask buffer_mask);
+dll_plugin_api void R_CmdClearColor(R_CommandBuffer* cmd, f32 r, f32 g, f32 b, f32 a);
+dll_plugin_api void R_CmdViewport(R_CommandBuffer* cmd, i32 x, i32 y, i32 w, i32 h);
+dll_plugin_api void R_CmdScissorEnable(R_CommandBuffer* cmd, i32 x, i32 y, i32 w, i32 h);
+dll_plugin_api void R_CmdScissorDisable(R_CommandBuffer* cmd);
+dll_plugin_api void R_CmdBlendDisable(R_CommandBuffer* cmd);
+dll_plugin_api void R_CmdBlendAlpha(R_CommandBuffer* cmd);
+dll_plugin_api void R_CmdDepthEnable(R_CommandBuffer* cmd);
+dll_plugin_api void R_CmdDepthDisable(R_CommandBuffer* cmd);
+dll_plugin_api void R_CmdCull(R_CommandBuffer* cmd, R_CullFace to_cull);
+dll_plugin_api void R_CmdDraw(R_CommandBuffer* cmd, R_Pipeline* pipeline, u32 start, u32 count);
+dll_plugin_api void R_CmdDrawIndexed(R_CommandBuffer* cmd, R_Pipeline* pipeline, u32 start, u32 count);
+dll_plugin_api void R_CmdDrawInstanced(R_CommandBuffer* cmd, R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count);
+dll_plugin_api void R_CmdDrawIndexedInstanced(R_CommandBuffer* cmd, R_Pipeline* pipeline, u32 start, u32 count, u32 instance_count);
+dll_plugin_api void R_CmdMultiDrawIndirect(R_CommandBuffer* cmd, R_Pipeline* pipeline, R_Buffer* commands, u32 draw_count);
+dll_plugin_api void R_CmdTimerBegin(R_CommandBuffer* cmd, string name);
+dll_plugin_api void R_CmdTimerEnd(R_CommandBuffer* cmd);
+
+//~ State Cache
+
+// Binds and state changes that reach the driver versus the ones the backend found redundant
+typedef struct R_StateStats {
+	u64 issued;
+	u64 skipped;
+} R_StateStats;
+
+dll_plugin_api R_StateStats R_StateStatsGet(void);
+dll_plugin_api void R_StateStatsReset(void);
+// Call after touching the graphics API directly, so the backend stops trusting its cached state
+dll_plugin_api void R_StateInvalidate(void);
+
+//~ GPU Timers
+
+#define R_GPU_TIMER_MAX 32
+#define R_GPU_TIMER_NAME_SIZE 32
+
+typedef struct R_GpuTiming {
+	u8 name[R_GPU_TIMER_NAME_SIZE];
+	u32 name_size;
+	u32 depth;
+	f64 gpu_ms;
+	f64 cpu_ms;
+} R_GpuTiming;
+
+// Scopes in submission order, a few frames behind the one being recorded.
+// gpu_timed is false when the context has no timer queries, gpu_ms then repeats the CPU time
+typedef struct R_GpuReport {
+	R_GpuTiming timings[R_GPU_TIMER_MAX];
+	u32 count;
+	b8 gpu_timed;
+} R_GpuReport;
+
+// Scopes nest, and also show up as debug groups in tools like RenderDoc when KHR_debug is around
+dll_plugin_api void R_GpuTimerBegin(string name);
+dll_plugin_api void R_GpuTimerEnd(void);
+// Call once per presented frame, after the swap
+dll_plugin_api void R_GpuTimerFrameEnd(void);
+dll_plugin_api R_GpuReport* R_GpuTimerReport(void);
+
+//~ Resource Tracking
+
+typedef u32 R_ResourceType;
+enum {
+	ResourceType_Buffer,
+	ResourceType_ShaderPack,
+	ResourceType_Pipeline,
+	ResourceType_Texture2D,
+	ResourceType_Framebuffer,
+	
+	ResourceType_MAX,
+};
+
+// Default for R_TextureBudgetSet. All textures count against it, but only evictable ones get dropped
+#define R_TEXTURE_BUDGET (256 * 1024 * 1024)
+
+typedef struct R_ResourceUsage {
+	u64 count[ResourceType_MAX];
+	u64 bytes[ResourceType_MAX];
+} R_ResourceUsage;
+
+// Called when a texture marked evictable is the least recently bound one and textures are over budget.
+// The owner is expected to free it, and reload it whenever it is needed again
+typedef void R_TextureEvictFunc(void* user);
+
+dll_plugin_api R_ResourceUsage R_ResourceUsageGet(void);
+// Logs every live object along with where it was created
+dll_plugin_api u32  R_ResourceReportLeaks(void);
+// Advances the LRU clock, and evicts textures while over budget. Call once per frame, presented or not
+dll_plugin_api void R_ResourceFrameEnd(void);
+// 0 means unlimited
+dll_plugin_api void R_TextureBudgetSet(u64 bytes);
+dll_plugin_api void R_Texture2DSetEvictable(R_Texture2D* texture, R_TextureEvictFunc* evict, void* user);
+
+// The allocators below pick up their call site through these macros. resources.c opts out
+dll_plugin_api void R_ResourceSite(const char* file, u32 line);
+
+#if !defined(R_RESOURCES_IMPL)
+#  define R_BufferAlloc(...)             (R_ResourceSite(__FILE__, __LINE__), R_BufferAlloc(__VA_ARGS__))
+#  define R_ShaderPackAlloc(...)         (R_ResourceSite(__FILE__, __LINE__), R_ShaderPackAlloc(__VA_ARGS__))
+#  define R_ShaderPackAllocLoad(...)     (R_ResourceSite(__FILE__, __LINE__), R_ShaderPackAllocLoad(__VA_ARGS__))
+#  define R_PipelineAlloc(...)           (R_ResourceSite(__FILE__, __LINE__), R_PipelineAlloc(__VA_ARGS__))
+#  define R_Texture2DAlloc(...)          (R_ResourceSite(__FILE__, __LINE__), R_Texture2DAlloc(__VA_ARGS__))
+#  define R_Texture2DAllocLoad(...)      (R_ResourceSite(__FILE__, __LINE__), R_Texture2DAllocLoad(__VA_ARGS__))
+#  define R_Texture2DAllocLoadAsync(...) (R_ResourceSite(__FILE__, __LINE__), R_Texture2DAllocLoadAsync(__VA_ARGS__))
+#  define R_Texture2DWhite(...)          (R_ResourceSite(__FILE__, __LINE__), R_Texture2DWhite(__VA_ARGS__))
+#  define R_FramebufferCreate(...)       (R_ResourceSite(__FILE__, __LINE__), R_FramebufferCreate(__VA_ARGS__))
+#  define R_ReadbackAlloc(...)           (R_ResourceSite(__FILE__, __LINE__), R_ReadbackAlloc(__VA_ARGS__))
+#  define R_RenderTargetAcquire(...)     (R_ResourceSite(__FILE__, __LINE__), R_RenderTargetAcquire(__VA_ARGS__))
+#endif
 
 #endif //RESOURCES_H
@@ -6,6 +6,8 @@
 #include "base/utils.h"
 #include "core/backend.h"
 #include "core/resources.h"
+#include "core/frame.h"
+#include "core/jobs.h"
 #include "opt/render_2d.h"
 #include "opt/ui.h"
 #include "client/client.h"
@@ -38,6 +40,7 @@ static fexp_context explorer_context = {0};
 static i32 plugin_idx = -1;
 static M_Arena global_arena;
 static R2D_Renderer renderer;
+static b8 show_gpu_report = false;
 
 void FilloutPluginStructures(M_Arena* arena) {
 	M_Scratch scratch = scratch_get();
@@ -92,6 +95,12 @@ void FilloutPluginStructures(M_Arena* arena) {
 }
 
 void key_callback(OS_Window* window, u8 key, i32 action) {
+	if (key == Input_Key_F3 && action == Input_Press) {
+		show_gpu_report = !show_gpu_report;
+		F_RequestRedraw();
+		return;
+	}
+	
 	if (plugin_idx == -1) {
 		fexp_input_key(&explorer_context, window, key, action);
 	} else {
@@ -101,6 +110,8 @@ void key_callback(OS_Window* window, u8 key, i32 action) {
 					all_plugins.elems[plugin_idx].free();
 				
 				plugin_idx = -1;
+				F_RequestContinuous(false);
+				R2D_Invalidate(&renderer);
 			}
 		} else {
 			if (all_plugins.elems[plugin_idx].key)
@@ -120,6 +131,7 @@ void resize_callback(OS_Window* window, i32 w, i32 h) {
 	if (!w || !h) return;
 	R_Viewport(0, 0, w, h);
 	R2D_ResizeProjection(&renderer, (vec2) { (f32)w, (f32)h });
+	F_RequestRedraw();
 	
 	if (plugin_idx != -1) {
 		if (all_plugins.elems[plugin_idx].resize)
@@ -138,6 +150,7 @@ b8 check_plugin(string name) {
 				string raised = str_copy(&global_arena, name);
 				if (all_plugins.elems[plugin_idx].init)
 					all_plugins.elems[plugin_idx].init(raised);
+				R2D_Invalidate(&renderer);
 				return true;
 			}
 		}
@@ -145,6 +158,27 @@ b8 check_plugin(string name) {
 	return false;
 }
 
+// F3 overlay. The timings are a few frames old, the queries are read back once the GPU is done with them
+void draw_gpu_report(R2D_FontInfo* font) {
+	M_Scratch scratch = scratch_get();
+	R_GpuReport* report = R_GpuTimerReport();
+	u32 old_layer = R2D_PushLayer(&renderer, R2D_LAYER_UI + 1);
+	
+	f32 y = 30;
+	for (u32 i = 0; i < report->count; i++) {
+		R_GpuTiming* timing = &report->timings[i];
+		string line = str_from_format(&scratch.arena, "%*s%.*s  gpu %.3fms  cpu %.3fms", timing->depth * 2, "",
+									  timing->name_size, timing->name, timing->gpu_ms, timing->cpu_ms);
+		R2D_DrawStringC(&renderer, font, (vec2) { 10, y }, line, report->gpu_timed ? Color_Yellow : Color_Cyan);
+		y += 24;
+	}
+	
+	R2D_PopLayer(&renderer, old_layer);
+	scratch_return(&scratch);
+	// Numbers change every frame, so keep them coming while the overlay is up
+	F_RequestRedraw();
+}
+
 int main() {
 	OS_Init();
 	
@@ -164,6 +198,7 @@ int main() {
 	
 	renderer = (R2D_Renderer) {0};
 	R2D_Init((vec2) { window->width, window->height }, &renderer);
+	renderer.preserved_backbuffer = B_BackendSwapPreservesContents(window);
 	UI_Init(&renderer);
 	
 	R2D_FontInfo font;
@@ -171,14 +206,15 @@ int main() {
 	explorer_context.font = &font;
 	fexp_init(&explorer_context);
 	
-	f32 start, end, dt;
-	start = OS_TimeMicrosecondsNow();
+	F_Init(60);
+	J_Init(0);
+	R_TextureBudgetSet(R_TEXTURE_BUDGET);
 	
 	while (OS_WindowIsOpen(window)) {
+		F_WaitForFrame();
 		OS_PollEvents();
-		end = OS_TimeMicrosecondsNow();
-		dt = (end - start) / 1e6;
-		start = OS_TimeMicrosecondsNow();
+		f32 dt = F_FrameBegin();
+		R_TextureLoadsPump(R_TEXTURE_UPLOAD_BUDGET);
 		
 		if (plugin_idx == -1) {
 			fexp_update(&explorer_context, dt);
@@ -187,23 +223,40 @@ int main() {
 				all_plugins.elems[plugin_idx].update(dt);
 		}
 		
-		R_Clear(BufferMask_Color);
-		
-		if (plugin_idx != -1) {
-			if (all_plugins.elems[plugin_idx].custom_render)
-				all_plugins.elems[plugin_idx].custom_render();
-		}
-		
 		R2D_BeginDraw(&renderer);
 		if (plugin_idx == -1) {
 			fexp_render(&explorer_context, &renderer);
 		} else {
 			if (all_plugins.elems[plugin_idx].render)
 				all_plugins.elems[plugin_idx].render(&renderer);
+			// Custom rendering isn't tracked, so it always redraws everything
+			if (all_plugins.elems[plugin_idx].custom_render)
+				R2D_Invalidate(&renderer);
+		}
+		
+		if (show_gpu_report) draw_gpu_report(&font);
+		
+		if (R2D_ResolveDamage(&renderer)) {
+			R_Clear(BufferMask_Color);
+			
+			if (plugin_idx != -1) {
+				if (all_plugins.elems[plugin_idx].custom_render) {
+					R_GpuTimerBegin(str_lit("CustomRender"));
+					all_plugins.elems[plugin_idx].custom_render();
+					R_GpuTimerEnd();
+				}
+			}
+			
+			R_GpuTimerBegin(str_lit("R2D"));
+			R2D_EndDraw(&renderer);
+			R_GpuTimerEnd();
+			B_BackendSwapchainNext(window);
+			R_GpuTimerFrameEnd();
 		}
-		R2D_EndDraw(&renderer);
+		// Ticks on idle frames too, so eviction and render target trimming don't wait for a repaint
+		R_ResourceFrameEnd();
 		
-		B_BackendSwapchainNext(window);
+		F_FrameEnd();
 	}
 	
 	if (plugin_idx != -1) {
@@ -211,10 +264,13 @@ int main() {
 			all_plugins.elems[plugin_idx].free();
 	}
 	
+	fexp_free(&explorer_context);
 	UI_Free();
 	R2D_FontFree(&font);
 	R2D_Free(&renderer);
+	R_RenderTargetsFlush();
 	
+	J_Shutdown();
 	B_BackendFree(window);
 	
 	OS_WindowClose(window);
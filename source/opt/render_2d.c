@@ -1,4 +1,11 @@
 #include "render_2d.h"
+#include <math.h>
+#include <float.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+#  define R2D_SIMD
+#endif
 
 //~ Font Loading
 
@@ -43,18 +50,57 @@ void R2D_FontFree(R2D_FontInfo* fontinfo) {
 //~ Internals
 
 Array_Impl(R2D_BatchArray, R2D_Batch);
+Array_Impl(R2D_DrawListRefArray, R2D_DrawListRef);
+
+static R_Attribute r2d_attributes[] = { Attribute_Float2, Attribute_Float2, Attribute_Float1, Attribute_Float4, Attribute_Float3, Attribute_Float2 };
+
+static void R2D_BatchListInit(R2D_BatchList* list) {
+	arena_init(&list->arena);
+	list->current_batch = 0;
+	R2D_BatchArray_add(&list->batches, (R2D_Batch) {0});
+	list->batches.elems[0].cache = R2D_VertexCacheCreate(&list->arena, R2D_MAX_INTERNAL_CACHE_VCOUNT);
+}
 
-static R2D_Batch* R2D_NextBatch(R2D_Renderer* renderer) {
-    R2D_Batch* next = &renderer->batches.elems[++renderer->current_batch];
+static void R2D_BatchListReset(R2D_BatchList* list) {
+	Iterate(list->batches, i) {
+		R2D_VertexCacheReset(&list->batches.elems[i].cache);
+		list->batches.elems[i].tex_count = 0;
+		list->batches.elems[i].retained = nullptr;
+		list->batches.elems[i].external = nullptr;
+		list->batches.elems[i].layer = 0;
+	}
+	list->current_batch = 0;
+	MemoryZero(list->open, sizeof(list->open));
+	list->bounds = (rect) {0};
+}
+
+static void R2D_BatchListFree(R2D_BatchList* list) {
+	R2D_BatchArray_free(&list->batches);
+	arena_free(&list->arena);
+}
+
+static R2D_Batch* R2D_NextBatch(R2D_BatchList* list) {
+    R2D_Batch* next = &list->batches.elems[++list->current_batch];
     
-    if (renderer->current_batch >= renderer->batches.len) {
-		R2D_BatchArray_add(&renderer->batches, (R2D_Batch) {});
-		next = &renderer->batches.elems[renderer->current_batch];
-        next->cache = R2D_VertexCacheCreate(&renderer->arena, R2D_MAX_INTERNAL_CACHE_VCOUNT);
+    if (list->current_batch >= list->batches.len) {
+		R2D_BatchArray_add(&list->batches, (R2D_Batch) {});
+		next = &list->batches.elems[list->current_batch];
+        next->cache = R2D_VertexCacheCreate(&list->arena, R2D_MAX_INTERNAL_CACHE_VCOUNT);
     }
     return next;
 }
 
+// Hands out a fresh batch for the given layer, reusing the last one if nothing has touched it.
+// Anything drawn on the layer afterwards has to come after this batch, so its open batch is closed
+static R2D_Batch* R2D_BatchListAppend(R2D_BatchList* list, u32 layer) {
+	R2D_Batch* batch = &list->batches.elems[list->current_batch];
+	if (batch->retained || batch->external || batch->cache.count)
+		batch = R2D_NextBatch(list);
+	batch->layer = layer;
+	list->open[layer] = 0;
+	return batch;
+}
+
 static b8 R2D_BatchCanAddTexture(R2D_Renderer* renderer, R2D_Batch* batch, R_Texture2D* texture) {
     if (batch->tex_count < 8) return true;
     for (u8 i = 0; i < batch->tex_count; i++) {
@@ -74,12 +120,51 @@ static u8 R2D_BatchAddTexture(R2D_Renderer* renderer, R2D_Batch* batch, R_Textur
 }
 
 static R2D_Batch* R2D_BatchGetCurrent(R2D_Renderer* renderer, int num_verts, R_Texture2D* tex) {
-    R2D_Batch* batch = &renderer->batches.elems[renderer->current_batch];
-    if (!R2D_BatchCanAddTexture(renderer, batch, tex) || batch->cache.count + num_verts >= batch->cache.max_verts)
-        batch = R2D_NextBatch(renderer);
+	R2D_BatchList* list = renderer->target;
+	u32 layer = renderer->layer;
+	u32 open = list->open[layer];
+	R2D_Batch* batch = open ? &list->batches.elems[open - 1] : nullptr;
+    if (!batch || !R2D_BatchCanAddTexture(renderer, batch, tex) || batch->cache.count + num_verts >= batch->cache.max_verts) {
+        batch = R2D_BatchListAppend(list, layer);
+		list->open[layer] = list->current_batch + 1;
+	}
     return batch;
 }
 
+// Stable counting sort of batch indices by layer. Layers are few, so one digit is enough
+static void R2D_BatchListSort(R2D_BatchList* list, u32* order) {
+	u32 offsets[R2D_MAX_LAYERS] = {0};
+	u32 count = list->current_batch + 1;
+	for (u32 i = 0; i < count; i++) offsets[list->batches.elems[i].layer]++;
+	u32 running = 0;
+	for (u32 l = 0; l < R2D_MAX_LAYERS; l++) {
+		u32 n = offsets[l];
+		offsets[l] = running;
+		running += n;
+	}
+	for (u32 i = 0; i < count; i++) order[offsets[list->batches.elems[i].layer]++] = i;
+}
+
+static void R2D_DrawBatch(R2D_Batch* batch, R_Pipeline* pipeline, R_Buffer* buffer, u32 start) {
+	for (u32 t = 0; t < batch->tex_count; t++) {
+		R_Texture2DBindTo(batch->textures[t], t);
+	}
+	if (buffer)
+		R_BufferUpdate(buffer, 0, batch->cache.count * sizeof(R2D_Vertex), (void*) batch->cache.vertices);
+	R_Draw(pipeline, start, batch->cache.count);
+}
+
+// Writes the six vertices of a quad whose corners are already clipped
+static void R2D_WriteQuad(R2D_Vertex* out, f32 x0, f32 y0, f32 x1, f32 y1, rect uv, vec4 color, vec3 rounding, i32 idx) {
+	f32 u0 = uv.x, v0 = uv.y, u1 = uv.x + uv.w, v1 = uv.y + uv.h;
+	out[0] = (R2D_Vertex) { .pos = { x0, y0 }, .tex_coords = { u0, v0 }, .tex_index = idx, .color = color, .roundingparams = rounding, .vertid = { 0, 0 } };
+	out[1] = (R2D_Vertex) { .pos = { x1, y0 }, .tex_coords = { u1, v0 }, .tex_index = idx, .color = color, .roundingparams = rounding, .vertid = { 1, 0 } };
+	out[2] = (R2D_Vertex) { .pos = { x1, y1 }, .tex_coords = { u1, v1 }, .tex_index = idx, .color = color, .roundingparams = rounding, .vertid = { 1, 1 } };
+	out[3] = out[0];
+	out[4] = out[2];
+	out[5] = (R2D_Vertex) { .pos = { x0, y1 }, .tex_coords = { u0, v1 }, .tex_index = idx, .color = color, .roundingparams = rounding, .vertid = { 0, 1 } };
+}
+
 //~ Vertex Cache
 
 R2D_VertexCache R2D_VertexCacheCreate(M_Arena* arena, u32 max_verts) {
@@ -105,26 +190,26 @@ b8 R2D_VertexCachePush(R2D_VertexCache* cache, R2D_Vertex* vertices, u32 vertex_
 //~ Renderer Core
 
 void R2D_Init(vec2 render_size, R2D_Renderer* renderer) {
-	arena_init(&renderer->arena);
+	R2D_BatchListInit(&renderer->immediate);
+	renderer->target = &renderer->immediate;
 	
-	renderer->current_batch = 0;
 	renderer->cull_quad = (rect) { 0, 0, render_size.x, render_size.y };
     renderer->offset = (vec2) { 0.f, 0.f };
-	R2D_BatchArray_add(&renderer->batches, (R2D_Batch) {0});
-	renderer->batches.elems[renderer->current_batch].cache = R2D_VertexCacheCreate(&renderer->arena, R2D_MAX_INTERNAL_CACHE_VCOUNT);
+	renderer->render_size = render_size;
+	renderer->invalidated = true;
 	
 	R_ShaderPackAllocLoad(&renderer->shader, str_lit("res/render_2d"));
-	R_Attribute attributes[] = { Attribute_Float2, Attribute_Float2, Attribute_Float1, Attribute_Float4, Attribute_Float3, Attribute_Float2 };
-	R_PipelineAlloc(&renderer->pipeline, InputAssembly_Triangles, attributes, ArrayCount(attributes), &renderer->shader);
+	renderer->u_projection = R_ShaderPackGetUniform(&renderer->shader, str_lit("u_projection"));
+	R_PipelineAlloc(&renderer->pipeline, InputAssembly_Triangles, r2d_attributes, ArrayCount(r2d_attributes), &renderer->shader);
 	R_BufferAlloc(&renderer->buffer, BufferFlag_Dynamic | BufferFlag_Type_Vertex);
 	R_BufferData(&renderer->buffer, R2D_MAX_INTERNAL_CACHE_VCOUNT * sizeof(R2D_Vertex), nullptr);
-	R_PipelineAddBuffer(&renderer->pipeline, &renderer->buffer, ArrayCount(attributes));
+	R_PipelineAddBuffer(&renderer->pipeline, &renderer->buffer, ArrayCount(r2d_attributes));
 	
 	R_PipelineBind(&renderer->pipeline);
 	i32 textures[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
 	R_ShaderPackUploadIntArray(&renderer->shader, str_lit("u_tex"), textures, 8);
 	mat4 projection = mat4_transpose(mat4_ortho(0, render_size.x, 0, render_size.y, -1, 1000));
-	R_ShaderPackUploadMat4(&renderer->shader, str_lit("u_projection"), projection);
+	R_UniformUploadMat4(renderer->u_projection, projection);
 	
 	R_Texture2DWhite(&renderer->white_texture);
 }
@@ -134,36 +219,243 @@ void R2D_Free(R2D_Renderer* renderer) {
 	R_BufferFree(&renderer->buffer);
 	R_PipelineFree(&renderer->pipeline);
 	R_ShaderPackFree(&renderer->shader);
-	arena_free(&renderer->arena);
+	R2D_DrawListRefArray_free(&renderer->submitted);
+	R2D_DrawListRefArray_free(&renderer->last_submitted);
+	R2D_BatchListFree(&renderer->immediate);
 }
 
 void R2D_ResizeProjection(R2D_Renderer* renderer, vec2 render_size) {
 	R_PipelineBind(&renderer->pipeline);
 	mat4 projection = mat4_transpose(mat4_ortho(0, render_size.x, 0, render_size.y, -1, 1000));
-	R_ShaderPackUploadMat4(&renderer->shader, str_lit("u_projection"), projection);
+	R_UniformUploadMat4(renderer->u_projection, projection);
+	renderer->render_size = render_size;
+	renderer->invalidated = true;
+}
+
+void R2D_Invalidate(R2D_Renderer* renderer) {
+	renderer->invalidated = true;
 }
 
 void R2D_BeginDraw(R2D_Renderer* renderer) {
 	R_BlendAlpha();
-	Iterate(renderer->batches, i) {
-		R2D_VertexCacheReset(&renderer->batches.elems[i].cache);
-		renderer->batches.elems[i].tex_count = 0;
+	R2D_BatchListReset(&renderer->immediate);
+	renderer->target = &renderer->immediate;
+	renderer->layer = R2D_LAYER_DEFAULT;
+	renderer->damage = (rect) {0};
+	
+	R2D_DrawListRefArray swap = renderer->last_submitted;
+	renderer->last_submitted = renderer->submitted;
+	renderer->submitted = swap;
+	renderer->submitted.len = 0;
+}
+
+// Works out what changed since the last frame and scissors to it. Only valid when the
+// swapchain keeps the back buffer, otherwise what's outside the damage is undefined and it all
+// gets redrawn. The previous frame's damage is repainted as well, which also covers a swapchain
+// that hands back the buffer from two frames ago
+b8 R2D_ResolveDamage(R2D_Renderer* renderer) {
+	rect damage = renderer->damage;
+	damage = rect_union(damage, renderer->immediate.bounds);
+	damage = rect_union(damage, renderer->last_immediate);
+	
+	// Lists that were drawn last frame but not this one leave a hole behind
+	Iterate(renderer->last_submitted, i) {
+		R2D_DrawListRef* old = &renderer->last_submitted.elems[i];
+		b8 found = false;
+		Iterate(renderer->submitted, k) {
+			if (renderer->submitted.elems[k].list == old->list) {
+				found = true;
+				break;
+			}
+		}
+		if (!found) damage = rect_union(damage, old->bounds);
 	}
-	renderer->current_batch = 0;
+	
+	rect full = { 0, 0, renderer->render_size.x, renderer->render_size.y };
+	if (renderer->invalidated || !renderer->preserved_backbuffer) damage = full;
+	
+	rect repaint = rect_union(damage, renderer->last_damage);
+	renderer->last_damage = damage;
+	renderer->last_immediate = renderer->immediate.bounds;
+	renderer->invalidated = false;
+	
+	if (repaint.w <= 0 || repaint.h <= 0) return false;
+	
+	if (rect_contained_by_rect(full, repaint)) {
+		R_ScissorDisable();
+	} else {
+		i32 x = (i32) floorf(repaint.x);
+		i32 y = (i32) floorf(repaint.y);
+		i32 w = (i32) ceilf(repaint.x + repaint.w) - x;
+		i32 h = (i32) ceilf(repaint.y + repaint.h) - y;
+		// GL scissor rects start at the bottom left
+		R_ScissorEnable(x, (i32) renderer->render_size.y - (y + h), w, h);
+	}
+	return true;
 }
 
 void R2D_EndDraw(R2D_Renderer* renderer) {
+	M_Scratch scratch = scratch_get();
+	R2D_BatchList* list = &renderer->immediate;
+	u32* order = arena_alloc(&scratch.arena, sizeof(u32) * (list->current_batch + 1));
+	R2D_BatchListSort(list, order);
+	
 	R_PipelineBind(&renderer->pipeline);
-	for (u32 i = 0; i < renderer->current_batch+1; i++) {
-		for (u32 t = 0; t < renderer->batches.elems[i].tex_count; t++) {
-			R_Texture2DBindTo(renderer->batches.elems[i].textures[t], t);
+	for (u32 i = 0; i < list->current_batch+1; i++) {
+		R2D_Batch* batch = &list->batches.elems[order[i]];
+		if (batch->retained) {
+			R2D_DrawList* retained = batch->retained;
+			if (!retained->buffer_vcount) continue;
+			R_PipelineBind(&retained->pipeline);
+			u32 start = 0;
+			for (u32 k = 0; k < retained->list.current_batch+1; k++) {
+				R2D_Batch* inner = &retained->list.batches.elems[k];
+				R2D_DrawBatch(inner, &retained->pipeline, nullptr, start);
+				start += inner->cache.count;
+			}
+			R_PipelineBind(&renderer->pipeline);
+		} else if (batch->external) {
+			R2D_DrawBatch(batch->external, &renderer->pipeline, &renderer->buffer, 0);
+		} else {
+			R2D_DrawBatch(batch, &renderer->pipeline, &renderer->buffer, 0);
 		}
-		R2D_VertexCache* cache = &renderer->batches.elems[i].cache;
-		R_BufferUpdate(&renderer->buffer, 0, cache->count * sizeof(R2D_Vertex), (void*) cache->vertices);
-		R_Draw(&renderer->pipeline, 0, cache->count);
 	}
+	R_ScissorDisable();
+	scratch_return(&scratch);
 }
 
+//~ Retained Draw Lists
+
+b8 R2D_DrawListBegin(R2D_Renderer* renderer, R2D_DrawList* list, u64 hash) {
+	if (!list->valid) {
+		R2D_BatchListInit(&list->list);
+		R_BufferAlloc(&list->buffer, BufferFlag_Dynamic | BufferFlag_Type_Vertex);
+		R_PipelineAlloc(&list->pipeline, InputAssembly_Triangles, r2d_attributes, ArrayCount(r2d_attributes), &renderer->shader);
+		list->buffer_vcount = 0;
+		list->valid = true;
+	} else if (list->hash == hash) {
+		return false;
+	}
+	
+	// Whatever the list covered before has to be repainted
+	renderer->damage = rect_union(renderer->damage, list->list.bounds);
+	list->hash = hash;
+	R2D_BatchListReset(&list->list);
+	renderer->target = &list->list;
+	return true;
+}
+
+void R2D_DrawListEnd(R2D_Renderer* renderer, R2D_DrawList* list) {
+	if (renderer->target == &list->list) {
+		renderer->target = &renderer->immediate;
+		renderer->damage = rect_union(renderer->damage, list->list.bounds);
+		
+		// The list is drawn in one go, so its layers get settled here
+		M_Scratch scratch = scratch_get();
+		u32 batch_count = list->list.current_batch + 1;
+		u32* order = arena_alloc(&scratch.arena, sizeof(u32) * batch_count);
+		R2D_Batch* sorted = arena_alloc(&scratch.arena, sizeof(R2D_Batch) * batch_count);
+		R2D_BatchListSort(&list->list, order);
+		for (u32 i = 0; i < batch_count; i++) sorted[i] = list->list.batches.elems[order[i]];
+		memcpy(list->list.batches.elems, sorted, sizeof(R2D_Batch) * batch_count);
+		MemoryZero(list->list.open, sizeof(list->list.open));
+		scratch_return(&scratch);
+		
+		u32 vcount = 0;
+		for (u32 i = 0; i < list->list.current_batch+1; i++)
+			vcount += list->list.batches.elems[i].cache.count;
+		
+		// Buffer storage is immutable on some backends, so growing means recreating
+		if (vcount > list->buffer_vcount) {
+			R_PipelineFree(&list->pipeline);
+			R_BufferFree(&list->buffer);
+			R_BufferAlloc(&list->buffer, BufferFlag_Dynamic | BufferFlag_Type_Vertex);
+			R_BufferData(&list->buffer, vcount * sizeof(R2D_Vertex), nullptr);
+			R_PipelineAlloc(&list->pipeline, InputAssembly_Triangles, r2d_attributes, ArrayCount(r2d_attributes), &renderer->shader);
+			R_PipelineAddBuffer(&list->pipeline, &list->buffer, ArrayCount(r2d_attributes));
+			list->buffer_vcount = vcount;
+		}
+		
+		u32 offset = 0;
+		for (u32 i = 0; i < list->list.current_batch+1; i++) {
+			R2D_VertexCache* cache = &list->list.batches.elems[i].cache;
+			if (cache->count) 
+				R_BufferUpdate(&list->buffer, offset * sizeof(R2D_Vertex), cache->count * sizeof(R2D_Vertex), (void*) cache->vertices);
+			offset += cache->count;
+		}
+	}
+	
+	R2D_DrawListRefArray_add(&renderer->submitted, (R2D_DrawListRef) { list, list->list.bounds });
+	
+	R2D_Batch* batch = R2D_BatchListAppend(&renderer->immediate, renderer->layer);
+	batch->retained = list;
+}
+
+void R2D_DrawListFree(R2D_DrawList* list) {
+	if (!list->valid) return;
+	R_PipelineFree(&list->pipeline);
+	R_BufferFree(&list->buffer);
+	R2D_BatchListFree(&list->list);
+	list->valid = false;
+}
+
+//~ Command Buffers
+
+R2D_Renderer* R2D_CommandBufferBegin(R2D_Renderer* renderer, R2D_CommandBuffer* cmd, u32 layer) {
+	R2D_Renderer* recorder = &cmd->recorder;
+	if (!cmd->inited) {
+		R2D_BatchListInit(&recorder->immediate);
+		cmd->inited = true;
+	}
+	R2D_BatchListReset(&recorder->immediate);
+	recorder->target = &recorder->immediate;
+	recorder->cull_quad = renderer->cull_quad;
+	recorder->offset = renderer->offset;
+	recorder->render_size = renderer->render_size;
+	recorder->white_texture = renderer->white_texture;
+	recorder->layer = Min(layer, R2D_MAX_LAYERS - 1);
+	cmd->layer = recorder->layer;
+	return recorder;
+}
+
+void R2D_CommandBuffersSubmit(R2D_Renderer* renderer, R2D_CommandBuffer* cmds, u32 count) {
+	M_Scratch scratch = scratch_get();
+	
+	// Stable order by layer, ties keep submission order so the result never depends on thread timing
+	u32* order = arena_alloc(&scratch.arena, sizeof(u32) * count);
+	for (u32 i = 0; i < count; i++) {
+		u32 k = i;
+		while (k > 0 && cmds[order[k - 1]].layer > cmds[i].layer) {
+			order[k] = order[k - 1];
+			k--;
+		}
+		order[k] = i;
+	}
+	
+	// Within a layer everything goes out in submission order, overlapping blended geometry from
+	// different buffers has to stack the way it was submitted. Neighbouring batches on one texture
+	// still only bind it once, the GL state cache drops the repeat
+	for (u32 i = 0; i < count; i++) {
+		R2D_BatchList* list = &cmds[order[i]].recorder.immediate;
+		renderer->immediate.bounds = rect_union(renderer->immediate.bounds, list->bounds);
+		for (u32 b = 0; b < list->current_batch + 1; b++) {
+			if (!list->batches.elems[b].cache.count) continue;
+			R2D_Batch* slot = R2D_BatchListAppend(&renderer->immediate, list->batches.elems[b].layer);
+			slot->external = &list->batches.elems[b];
+		}
+	}
+	
+	scratch_return(&scratch);
+}
+
+void R2D_CommandBufferFree(R2D_CommandBuffer* cmd) {
+	if (!cmd->inited) return;
+	R2D_BatchListFree(&cmd->recorder.immediate);
+	cmd->inited = false;
+}
+
+//~ Drawing
+
 rect R2D_PushCullRect(R2D_Renderer* renderer, rect new_quad) {
 	rect ret = renderer->cull_quad;
 	renderer->cull_quad = new_quad;
@@ -174,6 +466,16 @@ void R2D_PopCullRect(R2D_Renderer* renderer, rect old_quad) {
 	renderer->cull_quad = old_quad;
 }
 
+u32 R2D_PushLayer(R2D_Renderer* renderer, u32 layer) {
+	u32 ret = renderer->layer;
+	renderer->layer = Min(layer, R2D_MAX_LAYERS - 1);
+	return ret;
+}
+
+void R2D_PopLayer(R2D_Renderer* renderer, u32 old_layer) {
+	renderer->layer = old_layer;
+}
+
 vec2 R2D_PushOffset(R2D_Renderer* renderer, vec2 new_offset) {
 	vec2 ret = renderer->offset;
 	renderer->offset = new_offset;
@@ -193,58 +495,119 @@ void R2D_DrawQuad(R2D_Renderer* renderer, rect quad, R_Texture2D* texture, rect
 	R2D_Batch* batch = R2D_BatchGetCurrent(renderer, 6, texture);
 	i32 idx = R2D_BatchAddTexture(renderer, batch, texture);
 	rect uv_culled = rect_uv_cull(quad, uvs, renderer->cull_quad);
+	rect clipped = rect_get_overlap(quad, renderer->cull_quad);
+	renderer->target->bounds = rect_union(renderer->target->bounds, clipped);
 	
-	R2D_Vertex vertices[] = {
-		{
-            .pos = vec2_clamp(vec2_init(quad.x, quad.y), renderer->cull_quad),
-            .tex_index = idx,
-            .tex_coords = vec2_init(uv_culled.x, uv_culled.y),
-            .color = color,
-			.roundingparams = vec3_init(quad.w, quad.h, rounding),
-			.vertid = vec2_init(0, 0),
-		},
-        {
-            .pos = vec2_clamp(vec2_init(quad.x + quad.w, quad.y), renderer->cull_quad),
-            .tex_index = idx,
-            .tex_coords = vec2_init(uv_culled.x + uv_culled.w, uv_culled.y),
-            .color = color,
-			.roundingparams = vec3_init(quad.w, quad.h, rounding),
-			.vertid = vec2_init(1, 0),
-		},
-        {
-            .pos = vec2_clamp(vec2_init(quad.x + quad.w, quad.y + quad.h), renderer->cull_quad),
-            .tex_index = idx,
-            .tex_coords = vec2_init(uv_culled.x + uv_culled.w, uv_culled.y + uv_culled.h),
-            .color = color,
-			.roundingparams = vec3_init(quad.w, quad.h, rounding),
-			.vertid = vec2_init(1, 1),
-		},
-        {
-            .pos = vec2_clamp(vec2_init(quad.x, quad.y), renderer->cull_quad),
-            .tex_index = idx,
-            .tex_coords = vec2_init(uv_culled.x, uv_culled.y),
-            .color = color,
-			.roundingparams = vec3_init(quad.w, quad.h, rounding),
-			.vertid = vec2_init(0, 0),
-		},
-        {
-            .pos = vec2_clamp(vec2_init(quad.x + quad.w, quad.y + quad.h), renderer->cull_quad),
-            .tex_index = idx,
-            .tex_coords = vec2_init(uv_culled.x + uv_culled.w, uv_culled.y + uv_culled.h),
-            .color = color,
-			.roundingparams = vec3_init(quad.w, quad.h, rounding),
-			.vertid = vec2_init(1, 1),
-        },
-        {
-            .pos = vec2_clamp(vec2_init(quad.x, quad.y + quad.h), renderer->cull_quad),
-            .tex_index = idx,
-            .tex_coords = vec2_init(uv_culled.x, uv_culled.y + uv_culled.h),
-            .color = color,
-			.roundingparams = vec3_init(quad.w, quad.h, rounding),
-			.vertid = vec2_init(0, 1),
-        },
-	};
-	R2D_VertexCachePush(&batch->cache, vertices, 6);
+	R2D_WriteQuad(batch->cache.vertices + batch->cache.count,
+				  Max(quad.x, renderer->cull_quad.x), Max(quad.y, renderer->cull_quad.y),
+				  Min(quad.x + quad.w, renderer->cull_quad.x + renderer->cull_quad.w),
+				  Min(quad.y + quad.h, renderer->cull_quad.y + renderer->cull_quad.h),
+				  uv_culled, color, vec3_init(quad.w, quad.h, rounding), idx);
+	batch->cache.count += 6;
+}
+
+void R2D_DrawQuadsBatch(R2D_Renderer* renderer, R2D_QuadBatch* quads, R_Texture2D* texture, vec4 color, f32 rounding) {
+	if (!texture) texture = &renderer->white_texture;
+	u32 i = 0;
+	
+#if defined(R2D_SIMD)
+	rect cull = renderer->cull_quad;
+	__m128 cx = _mm_set1_ps(cull.x);
+	__m128 cy = _mm_set1_ps(cull.y);
+	__m128 cr = _mm_set1_ps(cull.x + cull.w);
+	__m128 cb = _mm_set1_ps(cull.y + cull.h);
+	__m128 ox = _mm_set1_ps(renderer->offset.x);
+	__m128 oy = _mm_set1_ps(renderer->offset.y);
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.f);
+	__m128 big = _mm_set1_ps(FLT_MAX);
+	__m128 bmin_x = big, bmin_y = big;
+	__m128 small = _mm_set1_ps(-FLT_MAX);
+	__m128 bmax_x = small, bmax_y = small;
+	
+	for (; i + 4 <= quads->count; i += 4) {
+		__m128 qx = _mm_add_ps(_mm_loadu_ps(quads->x + i), ox);
+		__m128 qy = _mm_add_ps(_mm_loadu_ps(quads->y + i), oy);
+		__m128 qw = _mm_loadu_ps(quads->w + i);
+		__m128 qh = _mm_loadu_ps(quads->h + i);
+		__m128 qr = _mm_add_ps(qx, qw);
+		__m128 qb = _mm_add_ps(qy, qh);
+		
+		// Same test as rect_overlaps, quads with no area are dropped as well
+		__m128 visible = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(qx, cr), _mm_cmpge_ps(qr, cx)),
+									_mm_and_ps(_mm_cmple_ps(qy, cb), _mm_cmpge_ps(qb, cy)));
+		visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpgt_ps(qw, zero), _mm_cmpgt_ps(qh, zero)));
+		i32 mask = _mm_movemask_ps(visible);
+		if (!mask) continue;
+		
+		__m128 x0 = _mm_max_ps(qx, cx);
+		__m128 y0 = _mm_max_ps(qy, cy);
+		__m128 x1 = _mm_min_ps(qr, cr);
+		__m128 y1 = _mm_min_ps(qb, cb);
+		
+		bmin_x = _mm_min_ps(bmin_x, _mm_or_ps(_mm_and_ps(visible, x0), _mm_andnot_ps(visible, big)));
+		bmin_y = _mm_min_ps(bmin_y, _mm_or_ps(_mm_and_ps(visible, y0), _mm_andnot_ps(visible, big)));
+		bmax_x = _mm_max_ps(bmax_x, _mm_or_ps(_mm_and_ps(visible, x1), _mm_andnot_ps(visible, small)));
+		bmax_y = _mm_max_ps(bmax_y, _mm_or_ps(_mm_and_ps(visible, y1), _mm_andnot_ps(visible, small)));
+		
+		// rect_uv_cull, the uv only shifts on the sides that got clipped
+		__m128 u  = quads->u  ? _mm_loadu_ps(quads->u + i)  : zero;
+		__m128 v  = quads->v  ? _mm_loadu_ps(quads->v + i)  : zero;
+		__m128 uw = quads->uw ? _mm_loadu_ps(quads->uw + i) : one;
+		__m128 vh = quads->vh ? _mm_loadu_ps(quads->vh + i) : one;
+		__m128 ratio_x = _mm_div_ps(uw, qw);
+		__m128 ratio_y = _mm_div_ps(vh, qh);
+		__m128 shift_x = _mm_andnot_ps(_mm_and_ps(_mm_cmpge_ps(qx, cx), _mm_cmple_ps(qx, cr)), one);
+		__m128 shift_y = _mm_andnot_ps(_mm_and_ps(_mm_cmpge_ps(qy, cy), _mm_cmple_ps(qy, cb)), one);
+		__m128 ow = _mm_sub_ps(x1, x0);
+		__m128 oh = _mm_sub_ps(y1, y0);
+		u = _mm_add_ps(u, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(qw, ow), ratio_x), shift_x));
+		v = _mm_add_ps(v, _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(qh, oh), ratio_y), shift_y));
+		uw = _mm_mul_ps(ow, ratio_x);
+		vh = _mm_mul_ps(oh, ratio_y);
+		
+		f32 lx0[4], ly0[4], lx1[4], ly1[4], lu[4], lv[4], luw[4], lvh[4], lw[4], lh[4];
+		_mm_storeu_ps(lx0, x0); _mm_storeu_ps(ly0, y0);
+		_mm_storeu_ps(lx1, x1); _mm_storeu_ps(ly1, y1);
+		_mm_storeu_ps(lu, u);   _mm_storeu_ps(lv, v);
+		_mm_storeu_ps(luw, uw); _mm_storeu_ps(lvh, vh);
+		_mm_storeu_ps(lw, qw);  _mm_storeu_ps(lh, qh);
+		
+		R2D_Batch* batch = R2D_BatchGetCurrent(renderer, 24, texture);
+		i32 idx = R2D_BatchAddTexture(renderer, batch, texture);
+		R2D_Vertex* out = batch->cache.vertices + batch->cache.count;
+		for (u32 k = 0; k < 4; k++) {
+			if (!(mask & (1 << k))) continue;
+			vec4 c = quads->r ? vec4_init(quads->r[i + k], quads->g[i + k], quads->b[i + k], quads->a[i + k]) : color;
+			R2D_WriteQuad(out, lx0[k], ly0[k], lx1[k], ly1[k], rect_init(lu[k], lv[k], luw[k], lvh[k]),
+						  c, vec3_init(lw[k], lh[k], rounding), idx);
+			out += 6;
+		}
+		batch->cache.count = (u32) (out - batch->cache.vertices);
+	}
+	
+	f32 mnx[4], mny[4], mxx[4], mxy[4];
+	_mm_storeu_ps(mnx, bmin_x); _mm_storeu_ps(mny, bmin_y);
+	_mm_storeu_ps(mxx, bmax_x); _mm_storeu_ps(mxy, bmax_y);
+	f32 min_x = Min(Min(mnx[0], mnx[1]), Min(mnx[2], mnx[3]));
+	f32 min_y = Min(Min(mny[0], mny[1]), Min(mny[2], mny[3]));
+	f32 max_x = Max(Max(mxx[0], mxx[1]), Max(mxx[2], mxx[3]));
+	f32 max_y = Max(Max(mxy[0], mxy[1]), Max(mxy[2], mxy[3]));
+	if (min_x < max_x && min_y < max_y) {
+		rect bounds = { min_x, min_y, max_x - min_x, max_y - min_y };
+		renderer->target->bounds = rect_union(renderer->target->bounds, bounds);
+	}
+#endif
+	
+	// Leftovers (and everything, without SIMD) go through the regular path
+	for (; i < quads->count; i++) {
+		// Same as the SIMD path, which drops quads with no area on top of the overlap test
+		if (!(quads->w[i] > 0.f && quads->h[i] > 0.f)) continue;
+		rect quad = { quads->x[i], quads->y[i], quads->w[i], quads->h[i] };
+		rect uvs = quads->u ? rect_init(quads->u[i], quads->v[i], quads->uw[i], quads->vh[i]) : rect_init(0.f, 0.f, 1.f, 1.f);
+		vec4 c = quads->r ? vec4_init(quads->r[i], quads->g[i], quads->b[i], quads->a[i]) : color;
+		R2D_DrawQuad(renderer, quad, texture, uvs, c, rounding);
+	}
 }
 
 void R2D_DrawQuadC(R2D_Renderer* renderer, rect quad, vec4 color, f32 rounding) {
@@ -259,33 +622,39 @@ void R2D_DrawQuadST(R2D_Renderer* renderer, rect quad, R_Texture2D* texture, rec
 	R2D_DrawQuad(renderer, quad, texture, uvs, tint, rounding);
 }
 
+// Glyphs are gathered into chunks and pushed through the batch path
+#define R2D_GLYPH_CHUNK 64
+
 void R2D_DrawStringC(R2D_Renderer* cb, R2D_FontInfo* fontinfo, vec2 pos, string str, vec4 color) {
+	f32 x[R2D_GLYPH_CHUNK], y[R2D_GLYPH_CHUNK], w[R2D_GLYPH_CHUNK], h[R2D_GLYPH_CHUNK];
+	f32 u[R2D_GLYPH_CHUNK], v[R2D_GLYPH_CHUNK], uw[R2D_GLYPH_CHUNK], vh[R2D_GLYPH_CHUNK];
+	R2D_QuadBatch quads = { .x = x, .y = y, .w = w, .h = h, .u = u, .v = v, .uw = uw, .vh = vh };
+	
     for (u32 i = 0; i < str.size; i++) {
         if (str.str[i] >= 32 && str.str[i] < 128) {
             stbtt_packedchar* info = &fontinfo->cdata[str.str[i] - 32];
-            rect uvs = { info->x0 / 512.f, info->y0 / 512.f, (info->x1 - info->x0) / 512.f, (info->y1 - info->y0) / 512.f };
-            rect loc = { pos.x + info->xoff, pos.y + info->yoff, info->x1 - info->x0, info->y1 - info->y0 };
-            R2D_DrawQuadST(cb, loc, &fontinfo->font_texture, uvs, color, 0);
+			u32 k = quads.count++;
+			x[k]  = pos.x + info->xoff;
+			y[k]  = pos.y + info->yoff;
+			w[k]  = info->x1 - info->x0;
+			h[k]  = info->y1 - info->y0;
+			u[k]  = info->x0 / 512.f;
+			v[k]  = info->y0 / 512.f;
+			uw[k] = (info->x1 - info->x0) / 512.f;
+			vh[k] = (info->y1 - info->y0) / 512.f;
             pos.x += info->xadvance;
+			
+			if (quads.count == R2D_GLYPH_CHUNK) {
+				R2D_DrawQuadsBatch(cb, &quads, &fontinfo->font_texture, color, 0);
+				quads.count = 0;
+			}
         }
     }
+	if (quads.count) R2D_DrawQuadsBatch(cb, &quads, &fontinfo->font_texture, color, 0);
 }
 
 void R2D_DrawString(R2D_Renderer* cb, R2D_FontInfo* fontinfo, vec2 pos, string str) {
-    for (u32 i = 0; i < str.size; i++) {
-        if (str.str[i] >= 32 && str.str[i] < 128) {
-            stbtt_packedchar* info = &fontinfo->cdata[str.str[i] - 32];
-            rect uvs = {
-                info->x0 / 512.f,
-                info->y0 / 512.f,
-                (info->x1 - info->x0) / 512.f,
-                (info->y1 - info->y0) / 512.f
-            };
-            rect loc = { pos.x + info->xoff, pos.y + info->yoff, info->x1 - info->x0, info->y1 - info->y0 };
-            R2D_DrawQuadST(cb, loc, &fontinfo->font_texture, uvs, vec4_init(1.f, 1.f, 1.f, 1.f), 0);
-            pos.x += info->xadvance;
-        }
-    }
+	R2D_DrawStringC(cb, fontinfo, pos, str, vec4_init(1.f, 1.f, 1.f, 1.f));
 }
 
 f32 R2D_GetStringSize(R2D_FontInfo* fontinfo, string str) {
@@ -47,29 +47,85 @@ dll_plugin_api R2D_VertexCache R2D_VertexCacheCreate(M_Arena* arena, u32 max_ver
 dll_plugin_api void R2D_VertexCacheReset(R2D_VertexCache* cache);
 dll_plugin_api b8   R2D_VertexCachePush(R2D_VertexCache* cache, R2D_Vertex* vertices, u32 vertex_count);
 
+// Layers are drawn back to front, draws within a layer keep their submission order
+#define R2D_MAX_LAYERS 32
+#define R2D_LAYER_DEFAULT 0
+#define R2D_LAYER_UI 16
+
+typedef struct R2D_DrawList R2D_DrawList;
+
 typedef struct R2D_Batch {
 	R2D_VertexCache cache;
     R_Texture2D *textures[8];
     u8 tex_count;
+	// If set, this batch draws a retained list instead of its own cache
+	R2D_DrawList* retained;
+	// If set, this batch draws a command buffer's batch instead of its own cache
+	struct R2D_Batch* external;
+	u32 layer;
 } R2D_Batch;
 
 Array_Prototype(R2D_BatchArray, R2D_Batch);
 
+// A growable run of batches. The renderer records into one of these every frame,
+// retained draw lists keep theirs around between frames
+typedef struct R2D_BatchList {
+	M_Arena arena;
+	R2D_BatchArray batches;
+	u32 current_batch;
+	// Index + 1 of the batch each layer is still filling, 0 if none
+	u32 open[R2D_MAX_LAYERS];
+	rect bounds;
+} R2D_BatchList;
+
+//~ Retained Draw Lists
+
+// The textures referenced by a retained list must outlive it
+struct R2D_DrawList {
+	R2D_BatchList list;
+	u64 hash;
+	b8  valid;
+	
+	R_Pipeline pipeline;
+	R_Buffer buffer;
+	u32 buffer_vcount;
+};
+
+typedef struct R2D_DrawListRef {
+	R2D_DrawList* list;
+	rect bounds;
+} R2D_DrawListRef;
+
+Array_Prototype(R2D_DrawListRefArray, R2D_DrawListRef);
+
 //~ Render API
 
 typedef struct R2D_Renderer {
-	M_Arena arena;
+	R2D_BatchList immediate;
+	R2D_BatchList* target;
 	
-	R2D_BatchArray batches;
-    u8 current_batch;
     rect cull_quad;
     vec2 offset;
-    
+    vec2 render_size;
+	u32  layer;
+	
+	// Damage tracking. Anything drawn immediately is damaged every frame,
+	// retained lists only when they are rebuilt, appear or disappear
+	rect damage;
+	rect last_immediate;
+	rect last_damage;
+	b8   invalidated;
+	// Set when the swapchain keeps the back buffer across swaps, without it every frame is a full repaint
+	b8   preserved_backbuffer;
+	R2D_DrawListRefArray submitted;
+	R2D_DrawListRefArray last_submitted;
+	
 	R_Texture2D white_texture;
 	
 	R_Pipeline pipeline;
 	R_Buffer buffer;
 	R_ShaderPack shader;
+	R_Uniform u_projection;
 } R2D_Renderer;
 
 dll_plugin_api void R2D_Init(vec2 render_size, R2D_Renderer* renderer);
@@ -77,10 +133,36 @@ dll_plugin_api void R2D_Free(R2D_Renderer* renderer);
 dll_plugin_api void R2D_ResizeProjection(R2D_Renderer* renderer, vec2 render_size);
 
 dll_plugin_api void R2D_BeginDraw(R2D_Renderer* renderer);
+dll_plugin_api b8   R2D_ResolveDamage(R2D_Renderer* renderer);
 dll_plugin_api void R2D_EndDraw(R2D_Renderer* renderer);
+dll_plugin_api void R2D_Invalidate(R2D_Renderer* renderer);
+
+// Returns true if the list has to be re-recorded. Draw calls made between
+// Begin and End go into the list instead of the current frame
+dll_plugin_api b8   R2D_DrawListBegin(R2D_Renderer* renderer, R2D_DrawList* list, u64 hash);
+dll_plugin_api void R2D_DrawListEnd(R2D_Renderer* renderer, R2D_DrawList* list);
+dll_plugin_api void R2D_DrawListFree(R2D_DrawList* list);
+
+//~ Command Buffers
+
+// Records on its own batch list, so a worker thread can fill one while others fill theirs
+typedef struct R2D_CommandBuffer {
+	R2D_Renderer recorder;
+	u32 layer;
+	b8  inited;
+} R2D_CommandBuffer;
+
+// Begin on the main thread, then draw into the returned recorder from any one thread
+dll_plugin_api R2D_Renderer* R2D_CommandBufferBegin(R2D_Renderer* renderer, R2D_CommandBuffer* cmd, u32 layer);
+// Merges recorded buffers into the current frame. Each buffer lands on its own layer,
+// within a layer batches keep submission order so overlapping buffers stack as submitted
+dll_plugin_api void R2D_CommandBuffersSubmit(R2D_Renderer* renderer, R2D_CommandBuffer* cmds, u32 count);
+dll_plugin_api void R2D_CommandBufferFree(R2D_CommandBuffer* cmd);
 
 dll_plugin_api rect R2D_PushCullRect(R2D_Renderer* renderer, rect new_quad);
 dll_plugin_api void R2D_PopCullRect(R2D_Renderer* renderer, rect old_quad);
+dll_plugin_api u32  R2D_PushLayer(R2D_Renderer* renderer, u32 layer);
+dll_plugin_api void R2D_PopLayer(R2D_Renderer* renderer, u32 old_layer);
 dll_plugin_api vec2 R2D_PushOffset(R2D_Renderer* renderer, vec2 new_offset);
 dll_plugin_api void R2D_PopOffset(R2D_Renderer* renderer, vec2 old_offset);
 
@@ -90,6 +172,19 @@ dll_plugin_api void R2D_DrawQuadT(R2D_Renderer* renderer, rect quad, R_Texture2D
 dll_plugin_api void R2D_DrawQuadST(R2D_Renderer* renderer, rect quad, R_Texture2D* texture, rect uvs, vec4 tint, f32 rounding);
 
 dll_plugin_api void R2D_DrawString(R2D_Renderer* renderer, R2D_FontInfo* fontinfo, vec2 pos, string str);
+// Structure-of-arrays input for R2D_DrawQuadsBatch. Positions are required,
+// uvs may be null for the full texture and colors may be null for a flat color
+typedef struct R2D_QuadBatch {
+	u32  count;
+	f32* x; f32* y; f32* w; f32* h;
+	f32* u; f32* v; f32* uw; f32* vh;
+	f32* r; f32* g; f32* b; f32* a;
+} R2D_QuadBatch;
+
+// Culls and clips four quads at a time and writes straight into batch memory.
+// A null texture draws with the white texture
+dll_plugin_api void R2D_DrawQuadsBatch(R2D_Renderer* renderer, R2D_QuadBatch* quads, R_Texture2D* texture, vec4 color, f32 rounding);
+
 dll_plugin_api void R2D_DrawStringC(R2D_Renderer* renderer, R2D_FontInfo* fontinfo, vec2 pos, string str, vec4 color);
 dll_plugin_api f32 R2D_GetStringSize(R2D_FontInfo* fontinfo, string str);
 
@@ -1,5 +1,6 @@
 #include "ui.h"
 #include <stdio.h>
+#include <math.h>
 
 Stack_Impl(UI_RegionStack, UI_Region);
 b8  void_ptr_null_eq(void* key) { return key == nullptr; }
@@ -77,7 +78,9 @@ b8 UI_Button(UI_Region region) {
 			color = _ui_state.colors[ColorProperty_Button_Hover];
 	}
 	
+	u32 old_layer = R2D_PushLayer(_ui_state.drawer, R2D_LAYER_UI);
 	R2D_DrawQuadC(_ui_state.drawer, region, color, _ui_state.floats[FloatProperty_Rounding]);
+	R2D_PopLayer(_ui_state.drawer, old_layer);
 	return click;
 }
 
@@ -92,6 +95,7 @@ b8 UI_Checkbox(UI_Region region, b8* value) {
         } else
             color = _ui_state.colors[ColorProperty_Checkbox_Hover];
     }
+    u32 old_layer = R2D_PushLayer(_ui_state.drawer, R2D_LAYER_UI);
     R2D_DrawQuadC(_ui_state.drawer, region, color, _ui_state.floats[FloatProperty_Rounding]);
     
     f32 checkbox_padding = _ui_state.floats[FloatProperty_Checkbox_Padding];
@@ -99,6 +103,7 @@ b8 UI_Checkbox(UI_Region region, b8* value) {
     
     if (*value)
         R2D_DrawQuadC(_ui_state.drawer, inner, _ui_state.colors[ColorProperty_Checkbox_Inner], _ui_state.floats[FloatProperty_Rounding]);
+    R2D_PopLayer(_ui_state.drawer, old_layer);
     return switched;
 }
 
@@ -108,7 +113,9 @@ b8 UI_ButtonLabeled(UI_Region region, string label) {
     f32 label_size = R2D_GetStringSize(_ui_state.font, label);
     f32 label_loc_x = region.x + (region.w / 2.f) - (label_size / 2.f);
     f32 label_loc_y = region.y + (region.h / 2.f) + (_ui_state.font->font_size / 4.f);
+    u32 old_layer = R2D_PushLayer(_ui_state.drawer, R2D_LAYER_UI);
     R2D_DrawString(_ui_state.drawer, _ui_state.font, (vec2) { label_loc_x, label_loc_y }, label);
+    R2D_PopLayer(_ui_state.drawer, old_layer);
     
     return r;
 }
@@ -166,13 +173,160 @@ b8 UI_Slider(UI_Region slider, vec2 bob_size, f32 min, f32 max, f32* value) {
     }
     
     // Draw
+    u32 old_layer = R2D_PushLayer(_ui_state.drawer, R2D_LAYER_UI);
     R2D_DrawQuadC(_ui_state.drawer, slider, _ui_state.colors[ColorProperty_Slider_Base], _ui_state.floats[FloatProperty_Rounding]);
     R2D_DrawQuadC(_ui_state.drawer, actual_bob, color, _ui_state.floats[FloatProperty_Rounding]);
+    R2D_PopLayer(_ui_state.drawer, old_layer);
 	return *slider_dragging;
 }
 
 void UI_Label(vec2 pos, string label) {
+    u32 old_layer = R2D_PushLayer(_ui_state.drawer, R2D_LAYER_UI);
     R2D_DrawString(_ui_state.drawer, _ui_state.font, pos, label);
+    R2D_PopLayer(_ui_state.drawer, old_layer);
+}
+
+//~ Property Grid
+
+void UI_PropertyGridInit(UI_PropertyGrid* grid, UI_PropertyField* fields, u32 field_count, f32 row_height) {
+    grid->fields = fields;
+    grid->field_count = field_count;
+    grid->row_height = row_height;
+    grid->scroll = 0.f;
+    grid->dragging = -1;
+}
+
+static f32 UI_PropertyGet(UI_PropertyField* field, void* object, u32 component) {
+    u8* at = (u8*) object + field->offset + component * 4;
+    if (field->kind == FieldKind_U32) return (f32) *(u32*) at;
+    return *(f32*) at;
+}
+
+static b8 UI_PropertySet(UI_PropertyField* field, void* object, u32 component, f32 value) {
+    u8* at = (u8*) object + field->offset + component * 4;
+    if (field->kind == FieldKind_U32) {
+        u32 rounded = (u32) (value + 0.5f);
+        if (*(u32*) at == rounded) return false;
+        *(u32*) at = rounded;
+        return true;
+    }
+    if (*(f32*) at == value) return false;
+    *(f32*) at = value;
+    return true;
+}
+
+b8 UI_PropertyGridEdit(UI_Region region, UI_PropertyGrid* grid, void* object) {
+    UI_Region parent = UI_RegionStack_peek(&_ui_state.stack);
+    rect actual = region;
+    actual.x += parent.x;
+    actual.y += parent.y;
+    
+    // Every row has the same layout, so everything under the mouse is worked out with arithmetic
+    // instead of asking each widget
+    f32 row_h = grid->row_height;
+    f32 label_w = region.w * 0.3f;
+    f32 column_w = (region.w - label_w) / UI_PROPERTY_GRID_MAX_COMPONENTS;
+    f32 padding = 8.f;
+    f32 track_w = column_w - 2 * padding;
+    vec2 bob_size = { 8.f, 14.f };
+    
+    vec2 mouse_pos = { OS_InputGetMouseX(), OS_InputGetMouseY() };
+    b8 hovered = rect_contains_point(actual, mouse_pos);
+    f32 max_scroll = Max(grid->field_count * row_h - region.h, 0.f);
+    if (hovered) grid->scroll -= OS_InputGetMouseScrollY() * row_h;
+    grid->scroll = Clamp(0.f, grid->scroll, max_scroll);
+    
+    i32 hot = -1;
+    if (hovered) {
+        u32 row = (u32) ((mouse_pos.y - actual.y + grid->scroll) / row_h);
+        f32 column_x = mouse_pos.x - actual.x - label_w;
+        if (row < grid->field_count && column_x >= 0.f) {
+            u32 column = (u32) (column_x / column_w);
+            f32 within = column_x - column * column_w;
+            if (column < grid->fields[row].count && within >= padding - bob_size.x && within <= column_w - padding + bob_size.x)
+                hot = row * UI_PROPERTY_GRID_MAX_COMPONENTS + column;
+        }
+    }
+    
+    if (OS_InputButtonPressed(Input_MouseButton_Left)) {
+        if (hot != -1) grid->dragging = hot;
+    } else if (OS_InputButtonReleased(Input_MouseButton_Left)) {
+        grid->dragging = -1;
+    }
+    
+    b8 changed = false;
+    if (grid->dragging >= (i32) (grid->field_count * UI_PROPERTY_GRID_MAX_COMPONENTS)) grid->dragging = -1;
+    if (grid->dragging != -1) {
+        UI_PropertyField* field = &grid->fields[grid->dragging / UI_PROPERTY_GRID_MAX_COMPONENTS];
+        u32 component = grid->dragging % UI_PROPERTY_GRID_MAX_COMPONENTS;
+        f32 track_x = actual.x + label_w + component * column_w + padding;
+        f32 t = Clamp(0.f, (mouse_pos.x - track_x) / track_w, 1.f);
+        changed = UI_PropertySet(field, object, component, field->min + t * (field->max - field->min));
+    }
+    
+    // Only the rows in view are laid out at all
+    u32 first = (u32) (grid->scroll / row_h);
+    u32 last = Min(grid->field_count, (u32) ceilf((grid->scroll + region.h) / row_h));
+    u32 capacity = (last - first) * UI_PROPERTY_GRID_MAX_COMPONENTS;
+    if (!capacity) return changed;
+    
+    M_Scratch scratch = scratch_get();
+    R2D_QuadBatch tracks = {0};
+    R2D_QuadBatch bobs = {0};
+    f32* memory = arena_alloc(&scratch.arena, sizeof(f32) * capacity * 12);
+    tracks.x = memory;                tracks.y = tracks.x + capacity;
+    tracks.w = tracks.y + capacity;   tracks.h = tracks.w + capacity;
+    bobs.x = tracks.h + capacity;     bobs.y = bobs.x + capacity;
+    bobs.w = bobs.y + capacity;       bobs.h = bobs.w + capacity;
+    bobs.r = bobs.h + capacity;       bobs.g = bobs.r + capacity;
+    bobs.b = bobs.g + capacity;       bobs.a = bobs.b + capacity;
+    
+    rect old_cull = R2D_PushCullRect(_ui_state.drawer, actual);
+    u32 old_layer = R2D_PushLayer(_ui_state.drawer, R2D_LAYER_UI);
+    
+    for (u32 row = first; row < last; row++) {
+        UI_PropertyField* field = &grid->fields[row];
+        f32 row_y = region.y + row * row_h - grid->scroll;
+        f32 text_y = row_y + row_h * 0.45f;
+        R2D_DrawString(_ui_state.drawer, _ui_state.font, (vec2) { region.x, text_y }, field->name);
+        
+        for (u32 c = 0; c < Min(field->count, UI_PROPERTY_GRID_MAX_COMPONENTS); c++) {
+            i32 id = row * UI_PROPERTY_GRID_MAX_COMPONENTS + c;
+            f32 value = UI_PropertyGet(field, object, c);
+            f32 t = field->max > field->min ? Clamp(0.f, (value - field->min) / (field->max - field->min), 1.f) : 0.f;
+            f32 track_x = region.x + label_w + c * column_w + padding;
+            f32 track_y = row_y + row_h * 0.75f;
+            
+            u32 k = tracks.count++;
+            tracks.x[k] = track_x;
+            tracks.y[k] = track_y - 2.f;
+            tracks.w[k] = track_w;
+            tracks.h[k] = 4.f;
+            
+            vec4 color = _ui_state.colors[ColorProperty_Slider_BobBase];
+            if (id == grid->dragging) color = _ui_state.colors[ColorProperty_Slider_BobDrag];
+            else if (id == hot) color = _ui_state.colors[ColorProperty_Slider_BobHover];
+            k = bobs.count++;
+            bobs.x[k] = track_x + t * track_w - bob_size.x / 2.f;
+            bobs.y[k] = track_y - bob_size.y / 2.f;
+            bobs.w[k] = bob_size.x;
+            bobs.h[k] = bob_size.y;
+            bobs.r[k] = color.x; bobs.g[k] = color.y; bobs.b[k] = color.z; bobs.a[k] = color.w;
+            
+            string text = field->kind == FieldKind_U32 ? str_from_format(&scratch.arena, "%u", (u32) value)
+                : str_from_format(&scratch.arena, "%.2f", value);
+            R2D_DrawString(_ui_state.drawer, _ui_state.font, (vec2) { track_x, text_y }, text);
+        }
+    }
+    
+    f32 rounding = _ui_state.floats[FloatProperty_Rounding];
+    R2D_DrawQuadsBatch(_ui_state.drawer, &tracks, nullptr, _ui_state.colors[ColorProperty_Slider_Base], rounding);
+    R2D_DrawQuadsBatch(_ui_state.drawer, &bobs, nullptr, _ui_state.colors[ColorProperty_Slider_BobBase], rounding);
+    
+    R2D_PopLayer(_ui_state.drawer, old_layer);
+    R2D_PopCullRect(_ui_state.drawer, old_cull);
+    scratch_return(&scratch);
+    return changed;
 }
 
 //~ Main Procedures
@@ -58,6 +58,41 @@ dll_plugin_api b8 UI_Checkbox(UI_Region region, b8* value);
 dll_plugin_api b8 UI_Slider(UI_Region slider, vec2 bob_size, f32 min, f32 max, f32* value);
 dll_plugin_api void UI_Label(vec2 pos, string label);
 
+// Property grid, edits a struct through a table of its fields, one row per field and a slider
+// per component. Only the rows in view are laid out, and each frame's tracks and bobs go out as
+// two quad batches no matter how many fields there are
+typedef u32 UI_FieldKind;
+enum {
+    FieldKind_F32,
+    FieldKind_U32,
+};
+
+typedef struct UI_PropertyField {
+    string name;
+    UI_FieldKind kind;
+    // Consecutive values edited together, like 2 for a vec2
+    u32 count;
+    u64 offset;
+    f32 min;
+    f32 max;
+} UI_PropertyField;
+
+#define UI_PROPERTY_GRID_MAX_COMPONENTS 4
+
+// Keep one around per grid, it holds the scroll position and the slider being dragged
+typedef struct UI_PropertyGrid {
+    UI_PropertyField* fields;
+    u32 field_count;
+    f32 row_height;
+    f32 scroll;
+    // field * UI_PROPERTY_GRID_MAX_COMPONENTS + component, -1 when nothing is held
+    i32 dragging;
+} UI_PropertyGrid;
+
+dll_plugin_api void UI_PropertyGridInit(UI_PropertyGrid* grid, UI_PropertyField* fields, u32 field_count, f32 row_height);
+// Returns true if any value in object changed this frame
+dll_plugin_api b8 UI_PropertyGridEdit(UI_Region region, UI_PropertyGrid* grid, void* object);
+
 dll_plugin_api void UI_Init(R2D_Renderer* drawer);
 dll_plugin_api void UI_Free();
 
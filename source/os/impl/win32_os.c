@@ -137,7 +137,7 @@ b32 OS_FileCreateWrite_List(string filename, string_list data) {
 	M_Scratch scratch = scratch_get();
 	string_utf16 filename16 = str16_from_str8(&scratch.arena, filename);
 	HANDLE file = CreateFileW((WCHAR*)filename16.str,
-							  GENERIC_READ, 0, 0,
+							  GENERIC_WRITE, 0, 0,
 							  CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL,
 							  0);
 	
@@ -609,6 +609,36 @@ void OS_TimeSleepMilliseconds(u32 t) {
 	Sleep(t);
 }
 
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#  define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+OS_Timer OS_TimerCreate(void) {
+	OS_Timer result = {0};
+	// The high resolution flag is Windows 10 1803 and up, older versions get a plain timer at the 1ms period
+	HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (!timer) timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+	result.v[0] = (u64) timer;
+	return result;
+}
+
+void OS_TimerSleepMicroseconds(OS_Timer* timer, u64 microseconds) {
+	// Relative due times are negative, in 100ns units
+	LARGE_INTEGER due = {0};
+	due.QuadPart = -(i64) (microseconds * 10);
+	HANDLE handle = (HANDLE) timer->v[0];
+	if (handle && SetWaitableTimer(handle, &due, 0, nullptr, nullptr, FALSE)) {
+		WaitForSingleObject(handle, INFINITE);
+	} else {
+		Sleep((DWORD) (microseconds / 1000));
+	}
+}
+
+void OS_TimerRelease(OS_Timer* timer) {
+	if (timer->v[0]) CloseHandle((HANDLE) timer->v[0]);
+	timer->v[0] = 0;
+}
+
 //~ Shared Libraries
 
 OS_Library OS_LibraryLoad(string path) {
@@ -643,16 +673,70 @@ void OS_ThreadWaitForJoin(OS_Thread* other) {
 	WaitForSingleObject((HANDLE)other->v[0], INFINITE);
 }
 
-void _OS_ThreadWaitForJoinAll(OS_Thread** threads, u32 count) {
+void OS_ThreadWaitForJoinAll(OS_Thread** threads, u32 count) {
 	HANDLE handles[count];
 	for (u32 i = 0; i < count; i++)
 		handles[i] = (HANDLE) threads[i]->v[0];
 	WaitForMultipleObjects(count, handles, TRUE, INFINITE);
 }
 
-void _OS_ThreadWaitForJoinAny(OS_Thread** threads, u32 count) {
+void OS_ThreadWaitForJoinAny(OS_Thread** threads, u32 count) {
 	HANDLE handles[count];
 	for (u32 i = 0; i < count; i++)
 		handles[i] = (HANDLE) threads[i]->v[0];
 	WaitForMultipleObjects(count, handles, FALSE, INFINITE);
 }
+
+b8 OS_ThreadIsDone(OS_Thread* thread) {
+	return WaitForSingleObject((HANDLE) thread->v[0], 0) == WAIT_OBJECT_0;
+}
+
+void OS_ThreadRelease(OS_Thread* thread) {
+	CloseHandle((HANDLE) thread->v[0]);
+	thread->v[0] = 0;
+}
+
+u32 OS_ProcessorCount(void) {
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+}
+
+void OS_MutexInit(OS_Mutex* mutex) {
+	InitializeSRWLock((SRWLOCK*) mutex->v);
+}
+
+void OS_MutexLock(OS_Mutex* mutex) {
+	AcquireSRWLockExclusive((SRWLOCK*) mutex->v);
+}
+
+void OS_MutexUnlock(OS_Mutex* mutex) {
+	ReleaseSRWLockExclusive((SRWLOCK*) mutex->v);
+}
+
+OS_Semaphore OS_SemaphoreCreate(u32 initial, u32 max) {
+	OS_Semaphore result = {0};
+	result.v[0] = (u64) CreateSemaphoreA(nullptr, initial, max, nullptr);
+	return result;
+}
+
+void OS_SemaphoreSignal(OS_Semaphore* semaphore, u32 count) {
+	ReleaseSemaphore((HANDLE) semaphore->v[0], count, nullptr);
+}
+
+void OS_SemaphoreWait(OS_Semaphore* semaphore) {
+	WaitForSingleObject((HANDLE) semaphore->v[0], INFINITE);
+}
+
+void OS_SemaphoreRelease(OS_Semaphore* semaphore) {
+	CloseHandle((HANDLE) semaphore->v[0]);
+	semaphore->v[0] = 0;
+}
+
+i32 OS_AtomicIncrement(volatile i32* value) {
+	return InterlockedIncrement((volatile LONG*) value);
+}
+
+i32 OS_AtomicDecrement(volatile i32* value) {
+	return InterlockedDecrement((volatile LONG*) value);
+}
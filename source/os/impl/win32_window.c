@@ -136,6 +136,13 @@ void OS_PollEvents() {
 	SwitchToFiber(_event_fibre);
 }
 
+// Blocks until there is a message in the queue or the timeout passes.
+// MWMO_INPUTAVAILABLE so messages that were already peeked at still count
+b8 OS_WaitForEvents(u32 timeout_ms) {
+	DWORD result = MsgWaitForMultipleObjectsEx(0, NULL, timeout_ms, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+	return result == WAIT_OBJECT_0;
+}
+
 static void DefaultResizeCallback(OS_Window* _window, i32 w, i32 h) {
 	W32_Window* window = (W32_Window*) _window;
 	window->width = (u32)w;
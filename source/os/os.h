@@ -99,6 +99,15 @@ dll_plugin_api U_DateTime OS_TimeUniversalFromLocal(U_DateTime* date_time);
 dll_plugin_api u64  OS_TimeMicrosecondsNow(void);
 dll_plugin_api void OS_TimeSleepMilliseconds(u32 t);
 
+typedef struct OS_Timer {
+	u64 v[1];
+} OS_Timer;
+
+// High resolution where the OS has it, so a sleep lands within a fraction of a millisecond without spinning
+dll_plugin_api OS_Timer OS_TimerCreate(void);
+dll_plugin_api void     OS_TimerSleepMicroseconds(OS_Timer* timer, u64 microseconds);
+dll_plugin_api void     OS_TimerRelease(OS_Timer* timer);
+
 //~ Shared Libraries
 
 // Just a buffer. will be OS specific
@@ -122,5 +131,29 @@ dll_plugin_api OS_Thread OS_ThreadCreate(thread_func* start, void* context);
 dll_plugin_api void      OS_ThreadWaitForJoin(OS_Thread* other);
 dll_plugin_api void      OS_ThreadWaitForJoinAll(OS_Thread** threads, u32 count);
 dll_plugin_api void      OS_ThreadWaitForJoinAny(OS_Thread** threads, u32 count);
+dll_plugin_api b8        OS_ThreadIsDone(OS_Thread* thread);
+dll_plugin_api void      OS_ThreadRelease(OS_Thread* thread);
+dll_plugin_api u32       OS_ProcessorCount(void);
+
+typedef struct OS_Mutex {
+	u64 v[1];
+} OS_Mutex;
+
+dll_plugin_api void OS_MutexInit(OS_Mutex* mutex);
+dll_plugin_api void OS_MutexLock(OS_Mutex* mutex);
+dll_plugin_api void OS_MutexUnlock(OS_Mutex* mutex);
+
+typedef struct OS_Semaphore {
+	u64 v[1];
+} OS_Semaphore;
+
+dll_plugin_api OS_Semaphore OS_SemaphoreCreate(u32 initial, u32 max);
+dll_plugin_api void         OS_SemaphoreSignal(OS_Semaphore* semaphore, u32 count);
+dll_plugin_api void         OS_SemaphoreWait(OS_Semaphore* semaphore);
+dll_plugin_api void         OS_SemaphoreRelease(OS_Semaphore* semaphore);
+
+// Both return the new value
+dll_plugin_api i32 OS_AtomicIncrement(volatile i32* value);
+dll_plugin_api i32 OS_AtomicDecrement(volatile i32* value);
 
 #endif //OS_H
@@ -25,6 +25,7 @@ dll_plugin_api OS_Window* OS_WindowCreate(u32 width, u32 height, string title);
 dll_plugin_api void OS_WindowShow(OS_Window* window);
 dll_plugin_api b8   OS_WindowIsOpen(OS_Window* window);
 dll_plugin_api void OS_PollEvents();
+dll_plugin_api b8   OS_WaitForEvents(u32 timeout_ms);
 dll_plugin_api void OS_WindowClose(OS_Window* window);
 
 #endif //WINDOW_H
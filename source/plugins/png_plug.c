@@ -1,11 +1,26 @@
 #include "base/log.h"
 #include "base/vmath.h"
+#include "base/utils.h"
 #include "opt/render_2d.h"
 #include <math.h>
 
 static R2D_FontInfo finfo = {0};
 static R_Texture2D texture = {0};
 static string fp = {0};
+static R2D_DrawList list = {0};
+static b8 evicted = false;
+
+// Over the texture budget, drop the image and decode it again the next time it is shown
+static void EvictTexture(void* user) {
+	R_Texture2DFree(&texture);
+	evicted = true;
+}
+
+static void LoadTexture(void) {
+	R_Texture2DAllocLoadAsync(&texture, fp, TextureResize_Linear, TextureResize_Linear, TextureWrap_Repeat, TextureWrap_Repeat);
+	R_Texture2DSetEvictable(&texture, EvictTexture, nullptr);
+	evicted = false;
+}
 
 dll_export string_array Extensions(M_Arena* arena) {
 	string exts[] = {
@@ -17,14 +32,22 @@ dll_export string_array Extensions(M_Arena* arena) {
 dll_export void Init(string filepath) {
 	fp = filepath;
 	R2D_FontLoad(&finfo, str_lit("res/Inconsolata.ttf"), 32.f);
-	R_Texture2DAllocLoad(&texture, filepath, TextureResize_Linear, TextureResize_Linear, TextureWrap_Repeat, TextureWrap_Repeat);
+	LoadTexture();
 }
 
 dll_export void Render(R2D_Renderer* renderer) {
-	R2D_DrawStringC(renderer, &finfo, (vec2) { 300 - (R2D_GetStringSize(&finfo, fp)/2.f), 60 }, fp, Color_Green);
-	R2D_DrawQuadT(renderer, (rect) { 100, 100, 400, 400 }, &texture, Color_White, 0);
+	if (evicted) LoadTexture();
+	u64 hash = U_HashBytes(U_HASH_SEED, fp.str, fp.size);
+	hash = U_HashBytes(hash, &texture, sizeof(R_Texture2D));
+	if (R2D_DrawListBegin(renderer, &list, hash)) {
+		R2D_DrawStringC(renderer, &finfo, (vec2) { 300 - (R2D_GetStringSize(&finfo, fp)/2.f), 60 }, fp, Color_Green);
+		R2D_DrawQuadT(renderer, (rect) { 100, 100, 400, 400 }, &texture, Color_White, 0);
+	}
+	R2D_DrawListEnd(renderer, &list);
 }
 
 dll_export void Free() {
+	R2D_DrawListFree(&list);
+	if (!evicted) R_Texture2DFree(&texture);
 	R2D_FontFree(&finfo);
 }
@@ -3,8 +3,19 @@
 #include "base/vmath.h"
 #include "opt/render_2d.h"
 #include "opt/ui.h"
+#include "core/frame.h"
+#include "core/jobs.h"
 #include <math.h>
-#include <stdlib.h>
+#include <stddef.h>
+#include <float.h>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define PSYS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#  include <emmintrin.h>
+#  define PSYS_SSE2
+#endif
 
 typedef struct psys_particle {
 	vec2 pos;
@@ -15,20 +26,1240 @@ typedef struct psys_particle {
 	f32 lifetime;
 } psys_particle;
 
-typedef struct psys_file {
+#define PsysMaxFields 4
+#define PsysMaxColliders 4
+
+typedef u32 psys_field_type;
+enum {
+	FieldType_None,
+	// Pulls towards pos, strength falls off to nothing at radius. A radius of 0 reaches everywhere
+	FieldType_Attractor,
+	// Swirls around pos counter clockwise, negative strength turns it around
+	FieldType_Vortex,
+	// Smooth noise pushing particles around, radius is the size of its features
+	FieldType_Turbulence,
+};
+
+typedef struct psys_force_field {
+	psys_field_type type;
+	vec2 pos;
+	f32 strength;
+	f32 radius;
+} psys_force_field;
+
+typedef u32 psys_collider_type;
+enum {
+	ColliderType_None,
+	// Everything on the side normal points away from is solid
+	ColliderType_Plane,
+	ColliderType_Circle,
+};
+
+typedef struct psys_collider {
+	psys_collider_type type;
+	vec2 pos;
+	vec2 normal;
+	f32 radius;
+	// 0 stops dead against it, 1 keeps all of the speed
+	f32 bounce;
+} psys_collider;
+
+typedef struct psys_emitter {
+	psys_particle blueprint;
+	psys_particle variance;
+	// Seconds between particles of the continuous stream, 0 turns it off
+	f32 speed;
+	u32 pool_size;
+	// burst_count particles at once every burst_interval seconds, an interval of 0 bursts once on open
+	u32 burst_count;
+	f32 burst_interval;
+	// Particles closer than repulsion_radius push each other apart
+	f32 repulsion;
+	f32 repulsion_radius;
+	psys_force_field fields[PsysMaxFields];
+	psys_collider colliders[PsysMaxColliders];
+} psys_emitter;
+
+// .psys files are little endian and 4 byte aligned throughout, so a mapped file can be read in place.
+// A psys_header, the emitter table at table_offset, then one block of properties per emitter.
+// Each property is a psys_property followed by count 4 byte values. Readers skip ids they don't know
+// and keep them on save, properties a file doesn't have keep their defaults. Only a change that
+// breaks this layout bumps the major version
+#define PsysMagic 0x53595350
+#define PsysVersionMajor 1
+#define PsysVersionMinor 0
+
+typedef struct psys_header {
+	u32 magic;
+	u16 major;
+	u16 minor;
+	u32 emitter_count;
+	u32 table_offset;
+} psys_header;
+
+typedef struct psys_emitter_entry {
+	u32 offset;
+	u32 size;
+} psys_emitter_entry;
+
+typedef u8 psys_property_type;
+enum {
+	PropertyType_F32,
+	PropertyType_U32,
+	// 4 byte words of a struct the property id describes
+	PropertyType_Words,
+};
+
+typedef u16 psys_property_id;
+enum {
+	EmitterProperty_Position = 1,
+	EmitterProperty_Velocity,
+	EmitterProperty_Acceleration,
+	EmitterProperty_Color,
+	EmitterProperty_ColorVelocity,
+	EmitterProperty_Lifetime,
+	EmitterProperty_Speed,
+	EmitterProperty_PoolSize,
+	EmitterProperty_BurstCount,
+	EmitterProperty_BurstInterval,
+	EmitterProperty_Repulsion,
+	EmitterProperty_ForceFields,
+	EmitterProperty_Colliders,
+};
+
+typedef struct psys_property {
+	psys_property_id id;
+	psys_property_type type;
+	u8 count;
+} psys_property;
+
+// Per particle properties are stored as the blueprint's values followed by the variance's
+typedef struct psys_property_desc {
+	psys_property_id id;
+	psys_property_type type;
+	u8 count;
+	b8 per_particle;
+	u32 offset;
+} psys_property_desc;
+
+static psys_property_desc psys_properties[] = {
+	{ EmitterProperty_Position,      PropertyType_F32, 2, true,  offsetof(psys_particle, pos) },
+	{ EmitterProperty_Velocity,      PropertyType_F32, 2, true,  offsetof(psys_particle, vel) },
+	{ EmitterProperty_Acceleration,  PropertyType_F32, 2, true,  offsetof(psys_particle, acc) },
+	{ EmitterProperty_Color,         PropertyType_F32, 4, true,  offsetof(psys_particle, color) },
+	{ EmitterProperty_ColorVelocity, PropertyType_F32, 4, true,  offsetof(psys_particle, color_vel) },
+	{ EmitterProperty_Lifetime,      PropertyType_F32, 1, true,  offsetof(psys_particle, lifetime) },
+	{ EmitterProperty_Speed,         PropertyType_F32, 1, false, offsetof(psys_emitter, speed) },
+	{ EmitterProperty_PoolSize,      PropertyType_U32, 1, false, offsetof(psys_emitter, pool_size) },
+	{ EmitterProperty_BurstCount,    PropertyType_U32, 1, false, offsetof(psys_emitter, burst_count) },
+	{ EmitterProperty_BurstInterval, PropertyType_F32, 1, false, offsetof(psys_emitter, burst_interval) },
+	{ EmitterProperty_Repulsion,     PropertyType_F32, 2, false, offsetof(psys_emitter, repulsion) },
+	{ EmitterProperty_ForceFields,   PropertyType_Words, sizeof(psys_force_field) / 4 * PsysMaxFields, false, offsetof(psys_emitter, fields) },
+	{ EmitterProperty_Colliders,     PropertyType_Words, sizeof(psys_collider) / 4 * PsysMaxColliders, false, offsetof(psys_emitter, colliders) },
+};
+
+// What .psys files were before the format above, a copy of the struct. Two of its three sizes predate
+// pool_size and the burst fields, and are still migrated
+typedef struct psys_legacy_file {
 	psys_particle blueprint;
 	psys_particle variance;
 	f32 speed;
-} psys_file;
+	u32 pool_size;
+	u32 burst_count;
+	f32 burst_interval;
+} psys_legacy_file;
+
+#define DefaultPoolSize 131072
+// Under 300MB of streams, grid and instances, well inside the plugin arena's reservation.
+// Files asking for more are clamped, a count near 2^32 would also overflow the grid sizing
+#define PsysMaxPoolSize (1u << 21)
+// Streams are padded to this, so the SIMD loops never need a scalar tail
+#define PoolLanes 8
+
+// Structure of arrays, live particles are packed into [0, count) and a dead one is swapped with the last
+typedef struct psys_pool {
+	f32* pos_x; f32* pos_y;
+	f32* vel_x; f32* vel_y;
+	f32* acc_x; f32* acc_y;
+	f32* r;  f32* g;  f32* b;  f32* a;
+	f32* dr; f32* dg; f32* db; f32* da;
+	f32* size;
+	f32* lifetime;
+	u32 count;
+	u32 capacity;
+} psys_pool;
+
+// The counting sort is split into this many slices no matter the core count,
+// so particles land in their cells in the same order on every machine
+#define GridSlices 8
+#define GridMinTableSize 256
+
+// Uniform grid of repulsion_radius sized cells, hashed into table_size buckets and rebuilt every step.
+// sorted holds particle indices bucket by bucket, bucket b's run starts at cell_start[b]
+typedef struct psys_grid {
+	// Picked each rebuild from the live count, up to table_capacity, so a few particles in a big pool
+	// don't pay for clearing and scanning a table sized for the whole pool
+	u32 table_size;
+	u32 table_capacity;
+	f32 cell_size;
+	u32* cell_of;
+	u32* sorted;
+	u32* cell_start;
+	// GridSlices rows of table_size, counts and then each slice's write cursors
+	u32* histogram;
+	u32 block_base[GridSlices];
+} psys_grid;
+
+// One running simulation, the one on screen and a bake each have their own
+typedef struct psys_sim {
+	psys_pool pool;
+	RNG_Batch rng;
+	f32 timer;
+	f32 burst_timer;
+	b8 bursts_done;
+	f32 time;
+	
+	// Everything below belongs to the step in flight, it runs on the job system
+	f32 dt;
+	psys_emitter emitter;
+	f32* force_x;
+	f32* force_y;
+	psys_grid grid;
+	J_Group group;
+} psys_sim;
 
 static M_Arena arena = {0};
 static string fp = {0};
-static psys_file data = {0};
-static f32 timer = 0.f;
+static psys_emitter data = {0};
+// The file as it was loaded, the emitters and properties this editor doesn't touch are saved from it
+static string loaded = {0};
+
+// Every run of the same file spawns the same particles, baked or not
+#define SpawnSeed 0x5053595355ull
+
+static psys_sim sim = {0};
+
+static void psys_pool_init(psys_pool* pool, M_Arena* arena, u32 capacity) {
+	capacity = (capacity + PoolLanes - 1) & ~(PoolLanes - 1);
+	f32** streams[] = {
+		&pool->pos_x, &pool->pos_y, &pool->vel_x, &pool->vel_y, &pool->acc_x, &pool->acc_y,
+		&pool->r, &pool->g, &pool->b, &pool->a, &pool->dr, &pool->dg, &pool->db, &pool->da,
+		&pool->size, &pool->lifetime,
+	};
+	for (u32 i = 0; i < ArrayCount(streams); i++)
+		*streams[i] = arena_alloc_zero(arena, sizeof(f32) * capacity);
+	pool->count = 0;
+	pool->capacity = capacity;
+}
+
+static void psys_sim_init(psys_sim* sim, M_Arena* arena, u32 capacity) {
+	psys_pool_init(&sim->pool, arena, capacity);
+	capacity = sim->pool.capacity;
+	RNG_BatchSeed(&sim->rng, SpawnSeed);
+	sim->timer = 0.f;
+	sim->burst_timer = 0.f;
+	sim->bursts_done = false;
+	sim->time = 0.f;
+	sim->group = (J_Group) {0};
+	
+	sim->force_x = arena_alloc_zero(arena, sizeof(f32) * capacity);
+	sim->force_y = arena_alloc_zero(arena, sizeof(f32) * capacity);
+	// At least one bucket per particle keeps unrelated cells from sharing one
+	u32 table_size = GridMinTableSize;
+	while (table_size < capacity) table_size <<= 1;
+	psys_grid* grid = &sim->grid;
+	grid->table_capacity = table_size;
+	grid->table_size = table_size;
+	grid->cell_of = arena_alloc(arena, sizeof(u32) * capacity);
+	grid->sorted = arena_alloc(arena, sizeof(u32) * capacity);
+	grid->cell_start = arena_alloc(arena, sizeof(u32) * (table_size + 1));
+	grid->histogram = arena_alloc(arena, sizeof(u32) * table_size * GridSlices);
+}
+
+static void psys_pool_remove(psys_pool* pool, u32 i) {
+	u32 last = --pool->count;
+	pool->pos_x[i] = pool->pos_x[last]; pool->pos_y[i] = pool->pos_y[last];
+	pool->vel_x[i] = pool->vel_x[last]; pool->vel_y[i] = pool->vel_y[last];
+	pool->acc_x[i] = pool->acc_x[last]; pool->acc_y[i] = pool->acc_y[last];
+	pool->r[i] = pool->r[last]; pool->g[i] = pool->g[last];
+	pool->b[i] = pool->b[last]; pool->a[i] = pool->a[last];
+	pool->dr[i] = pool->dr[last]; pool->dg[i] = pool->dg[last];
+	pool->db[i] = pool->db[last]; pool->da[i] = pool->da[last];
+	pool->size[i] = pool->size[last];
+	pool->lifetime[i] = pool->lifetime[last];
+}
+
+// x += v * dt over the padded range, every integration step in the sim is one of these
+static void psys_integrate(f32* x, f32* v, f32 dt, u32 count) {
+	u32 i = 0;
+#if defined(PSYS_AVX2)
+	__m256 vdt = _mm256_set1_ps(dt);
+	for (; i < count; i += 8)
+		_mm256_storeu_ps(x + i, _mm256_add_ps(_mm256_loadu_ps(x + i), _mm256_mul_ps(_mm256_loadu_ps(v + i), vdt)));
+#elif defined(PSYS_SSE2)
+	__m128 vdt = _mm_set1_ps(dt);
+	for (; i < count; i += 4)
+		_mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x + i), _mm_mul_ps(_mm_loadu_ps(v + i), vdt)));
+#endif
+	for (; i < count; i++) x[i] += v[i] * dt;
+}
+
+static void psys_age(f32* lifetime, f32 dt, u32 count) {
+	u32 i = 0;
+#if defined(PSYS_AVX2)
+	__m256 vdt = _mm256_set1_ps(dt);
+	for (; i < count; i += 8)
+		_mm256_storeu_ps(lifetime + i, _mm256_sub_ps(_mm256_loadu_ps(lifetime + i), vdt));
+#elif defined(PSYS_SSE2)
+	__m128 vdt = _mm_set1_ps(dt);
+	for (; i < count; i += 4)
+		_mm_storeu_ps(lifetime + i, _mm_sub_ps(_mm_loadu_ps(lifetime + i), vdt));
+#endif
+	for (; i < count; i++) lifetime[i] -= dt;
+}
+
+static void psys_cull_dead(psys_pool* pool) {
+	u32 i = 0;
+	while (i < pool->count) {
+#if defined(PSYS_SSE2) || defined(PSYS_AVX2)
+		// Most of the pool is alive on any given frame, skip it four at a time
+		if (i + 4 <= pool->count &&
+			!_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(pool->lifetime + i), _mm_setzero_ps()))) {
+			i += 4;
+			continue;
+		}
+#endif
+		// The swapped in particle hasn't been checked yet, so i stays put
+		if (pool->lifetime[i] <= 0.f) psys_pool_remove(pool, i);
+		else i++;
+	}
+}
+
+// Everything the GPU needs to draw one particle, the quad is expanded in res/particles.vert.glsl
+typedef struct psys_instance {
+	f32 x, y;
+	f32 size;
+	// RGBA8, red in the low byte
+	u32 color;
+} psys_instance;
+
+static R_Attribute instance_attributes[] = { Attribute_Float3, Attribute_Integer1 };
+
+static psys_instance* instances = nullptr;
+// What CustomRender draws, the live pool's records or a decoded bake frame
+static psys_instance* drawn = nullptr;
+static u32 instance_count = 0;
+static R_ShaderPack instance_shader = {0};
+static R_Pipeline instance_pipeline = {0};
+static R_Buffer instance_buffer = {0};
+static u32 instance_capacity = 0;
+static R_Uniform u_projection = {0};
+static R_Uniform u_offset = {0};
+static mat4 projection = {0};
+static vec2 offset = {0};
+
+// The pool is packed as this many jobs at most, one slice each
+#define PackJobCount 8
+
+typedef struct psys_pack_job {
+	psys_pool* pool;
+	u32 start;
+	u32 end;
+} psys_pack_job;
+
+static u32 psys_pack_color(f32 r, f32 g, f32 b, f32 a) {
+	u32 ri = (u32) (Clamp(0.f, r, 1.f) * 255.f + 0.5f);
+	u32 gi = (u32) (Clamp(0.f, g, 1.f) * 255.f + 0.5f);
+	u32 bi = (u32) (Clamp(0.f, b, 1.f) * 255.f + 0.5f);
+	u32 ai = (u32) (Clamp(0.f, a, 1.f) * 255.f + 0.5f);
+	return ri | (gi << 8) | (bi << 16) | (ai << 24);
+}
+
+static void psys_pack_range(void* context, u32 index) {
+	psys_pack_job* job = (psys_pack_job*) context + index;
+	psys_pool* pool = job->pool;
+	u32 i = job->start;
+#if defined(PSYS_SSE2) || defined(PSYS_AVX2)
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.f);
+	__m128 full = _mm_set1_ps(255.f);
+	for (; i + 4 <= job->end; i += 4) {
+		__m128i r = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pool->r + i), zero), one), full));
+		__m128i g = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pool->g + i), zero), one), full));
+		__m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pool->b + i), zero), one), full));
+		__m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(pool->a + i), zero), one), full));
+		__m128i rgba = _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, 8)),
+									_mm_or_si128(_mm_slli_epi32(b, 16), _mm_slli_epi32(a, 24)));
+		
+		// Four streams in, four records out
+		__m128 x = _mm_loadu_ps(pool->pos_x + i);
+		__m128 y = _mm_loadu_ps(pool->pos_y + i);
+		__m128 size = _mm_loadu_ps(pool->size + i);
+		__m128 color = _mm_castsi128_ps(rgba);
+		_MM_TRANSPOSE4_PS(x, y, size, color);
+		_mm_storeu_ps((f32*) (instances + i), x);
+		_mm_storeu_ps((f32*) (instances + i + 1), y);
+		_mm_storeu_ps((f32*) (instances + i + 2), size);
+		_mm_storeu_ps((f32*) (instances + i + 3), color);
+	}
+#endif
+	for (; i < job->end; i++) {
+		instances[i] = (psys_instance) {
+			pool->pos_x[i], pool->pos_y[i], pool->size[i],
+			psys_pack_color(pool->r[i], pool->g[i], pool->b[i], pool->a[i]),
+		};
+	}
+}
+
+// Integration runs as one job per chunk of this many particles, a multiple of PoolLanes
+#define SimChunkSize 16384
+// Neighbour queries cost a lot more per particle, so they're cut finer to balance across workers
+#define ForceChunkSize 2048
+
+static void psys_slice(u32 count, u32 slices, u32 index, u32* start, u32* end) {
+	*start = (u32) ((u64) count * index / slices);
+	*end = (u32) ((u64) count * (index + 1) / slices);
+}
+
+static u32 psys_grid_bucket(psys_grid* grid, i32 cx, i32 cy) {
+	u32 h = (u32) cx * 73856093u ^ (u32) cy * 19349663u;
+	return h & (grid->table_size - 1);
+}
+
+static u32 psys_grid_bucket_of(psys_grid* grid, f32 x, f32 y) {
+	return psys_grid_bucket(grid, (i32) floorf(x / grid->cell_size), (i32) floorf(y / grid->cell_size));
+}
+
+static void psys_grid_count(void* context, u32 index) {
+	psys_sim* sim = (psys_sim*) context;
+	psys_grid* grid = &sim->grid;
+	u32* histogram = grid->histogram + index * grid->table_size;
+	memset(histogram, 0, sizeof(u32) * grid->table_size);
+	u32 start, end;
+	psys_slice(sim->pool.count, GridSlices, index, &start, &end);
+	for (u32 i = start; i < end; i++) {
+		u32 bucket = psys_grid_bucket_of(grid, sim->pool.pos_x[i], sim->pool.pos_y[i]);
+		grid->cell_of[i] = bucket;
+		histogram[bucket]++;
+	}
+}
+
+// The scan is done in GridSlices blocks of buckets, the per block totals are summed in between
+static void psys_grid_block_total(void* context, u32 index) {
+	psys_sim* sim = (psys_sim*) context;
+	psys_grid* grid = &sim->grid;
+	u32 start, end;
+	psys_slice(grid->table_size, GridSlices, index, &start, &end);
+	u32 total = 0;
+	for (u32 s = 0; s < GridSlices; s++) {
+		u32* histogram = grid->histogram + s * grid->table_size;
+		for (u32 b = start; b < end; b++) total += histogram[b];
+	}
+	grid->block_base[index] = total;
+}
+
+static void psys_grid_block_offsets(void* context, u32 index) {
+	psys_sim* sim = (psys_sim*) context;
+	psys_grid* grid = &sim->grid;
+	u32 start, end;
+	psys_slice(grid->table_size, GridSlices, index, &start, &end);
+	u32 running = grid->block_base[index];
+	for (u32 b = start; b < end; b++) {
+		grid->cell_start[b] = running;
+		// Counts become cursors, slice s writes its particles after every earlier slice's
+		for (u32 s = 0; s < GridSlices; s++) {
+			u32* slot = grid->histogram + s * grid->table_size + b;
+			u32 count = *slot;
+			*slot = running;
+			running += count;
+		}
+	}
+}
+
+static void psys_grid_scatter(void* context, u32 index) {
+	psys_sim* sim = (psys_sim*) context;
+	psys_grid* grid = &sim->grid;
+	u32* cursors = grid->histogram + index * grid->table_size;
+	u32 start, end;
+	psys_slice(sim->pool.count, GridSlices, index, &start, &end);
+	for (u32 i = start; i < end; i++)
+		grid->sorted[cursors[grid->cell_of[i]]++] = i;
+}
+
+static void psys_sim_run(psys_sim* sim, J_JobFunc* func, u32 count) {
+	J_Group group = {0};
+	J_Dispatch(&group, func, sim, count);
+	J_Wait(&group);
+}
+
+static void psys_grid_build(psys_sim* sim) {
+	psys_grid* grid = &sim->grid;
+	grid->cell_size = sim->emitter.repulsion_radius;
+	u32 table_size = GridMinTableSize;
+	while (table_size < sim->pool.count && table_size < grid->table_capacity) table_size <<= 1;
+	grid->table_size = table_size;
+	psys_sim_run(sim, psys_grid_count, GridSlices);
+	psys_sim_run(sim, psys_grid_block_total, GridSlices);
+	u32 running = 0;
+	for (u32 i = 0; i < GridSlices; i++) {
+		u32 total = grid->block_base[i];
+		grid->block_base[i] = running;
+		running += total;
+	}
+	grid->cell_start[grid->table_size] = running;
+	psys_sim_run(sim, psys_grid_block_offsets, GridSlices);
+	psys_sim_run(sim, psys_grid_scatter, GridSlices);
+}
+
+static b8 psys_emitter_has_repulsion(psys_emitter* emitter) {
+	return emitter->repulsion != 0.f && emitter->repulsion_radius > 0.f;
+}
+
+static b8 psys_emitter_has_fields(psys_emitter* emitter) {
+	for (u32 i = 0; i < PsysMaxFields; i++)
+		if (emitter->fields[i].type != FieldType_None && emitter->fields[i].strength != 0.f) return true;
+	return false;
+}
+
+static b8 psys_emitter_has_colliders(psys_emitter* emitter) {
+	for (u32 i = 0; i < PsysMaxColliders; i++)
+		if (emitter->colliders[i].type != ColliderType_None) return true;
+	return false;
+}
+
+static vec2 psys_field_force(psys_force_field* field, f32 x, f32 y, f32 time) {
+	f32 dx = field->pos.x - x;
+	f32 dy = field->pos.y - y;
+	f32 dist = sqrtf(dx * dx + dy * dy);
+	if (field->type == FieldType_Turbulence) {
+		// Two octaves of sines, cheap, smooth and the same wherever it's evaluated
+		f32 k = 1.f / Max(field->radius, 1.f);
+		f32 fx = sinf(y * k + time * 1.3f) + 0.5f * sinf(y * k * 2.7f - time * 0.7f);
+		f32 fy = cosf(x * k + time * 1.7f) + 0.5f * cosf(x * k * 2.3f + time * 0.9f);
+		return (vec2) { fx * field->strength, fy * field->strength };
+	}
+	
+	if (dist < 0.0001f) return (vec2) {0};
+	f32 falloff = 1.f;
+	if (field->radius > 0.f) {
+		if (dist >= field->radius) return (vec2) {0};
+		falloff = 1.f - dist / field->radius;
+	}
+	f32 scale = field->strength * falloff / dist;
+	if (field->type == FieldType_Attractor) return (vec2) { dx * scale, dy * scale };
+	if (field->type == FieldType_Vortex) return (vec2) { dy * scale, -dx * scale };
+	return (vec2) {0};
+}
+
+static void psys_force_chunk(void* context, u32 index) {
+	psys_sim* sim = (psys_sim*) context;
+	psys_pool* pool = &sim->pool;
+	psys_grid* grid = &sim->grid;
+	psys_emitter* emitter = &sim->emitter;
+	u32 start = index * ForceChunkSize;
+	u32 end = Min(pool->count, start + ForceChunkSize);
+	b8 repulsion = psys_emitter_has_repulsion(emitter);
+	f32 radius = emitter->repulsion_radius;
+	
+	for (u32 i = start; i < end; i++) {
+		f32 x = pool->pos_x[i];
+		f32 y = pool->pos_y[i];
+		f32 fx = 0.f;
+		f32 fy = 0.f;
+		
+		for (u32 f = 0; f < PsysMaxFields; f++) {
+			if (emitter->fields[f].type == FieldType_None) continue;
+			vec2 force = psys_field_force(&emitter->fields[f], x, y, sim->time);
+			fx += force.x;
+			fy += force.y;
+		}
+		
+		if (repulsion) {
+			// Cells are as wide as the radius, so the 3x3 around the particle covers every neighbour
+			i32 cx = (i32) floorf(x / grid->cell_size);
+			i32 cy = (i32) floorf(y / grid->cell_size);
+			u32 visited[9];
+			u32 visited_count = 0;
+			for (i32 oy = -1; oy <= 1; oy++) {
+				for (i32 ox = -1; ox <= 1; ox++) {
+					u32 bucket = psys_grid_bucket(grid, cx + ox, cy + oy);
+					// Two neighbouring cells can hash to one bucket, don't count it twice
+					b8 seen = false;
+					for (u32 v = 0; v < visited_count; v++) seen |= visited[v] == bucket;
+					if (seen) continue;
+					visited[visited_count++] = bucket;
+					
+					for (u32 k = grid->cell_start[bucket]; k < grid->cell_start[bucket + 1]; k++) {
+						u32 j = grid->sorted[k];
+						f32 dx = x - pool->pos_x[j];
+						f32 dy = y - pool->pos_y[j];
+						f32 d2 = dx * dx + dy * dy;
+						// Also skips i itself, and anything from a far cell sharing the bucket
+						if (d2 >= radius * radius || d2 < 0.000001f) continue;
+						f32 d = sqrtf(d2);
+						f32 push = emitter->repulsion * (1.f - d / radius) / d;
+						fx += dx * push;
+						fy += dy * push;
+					}
+				}
+			}
+		}
+		
+		sim->force_x[i] = fx;
+		sim->force_y[i] = fy;
+	}
+}
+
+static void psys_collide(psys_pool* pool, psys_collider* collider, u32 i) {
+	f32 px = pool->pos_x[i];
+	f32 py = pool->pos_y[i];
+	f32 nx, ny, depth;
+	if (collider->type == ColliderType_Plane) {
+		f32 len = sqrtf(collider->normal.x * collider->normal.x + collider->normal.y * collider->normal.y);
+		if (len < 0.0001f) return;
+		nx = collider->normal.x / len;
+		ny = collider->normal.y / len;
+		depth = -((px - collider->pos.x) * nx + (py - collider->pos.y) * ny);
+	} else if (collider->type == ColliderType_Circle) {
+		f32 dx = px - collider->pos.x;
+		f32 dy = py - collider->pos.y;
+		f32 dist = sqrtf(dx * dx + dy * dy);
+		if (dist < 0.0001f) return;
+		nx = dx / dist;
+		ny = dy / dist;
+		depth = collider->radius - dist;
+	} else return;
+	if (depth <= 0.f) return;
+	
+	// Out onto the surface, and the velocity into it reflected
+	pool->pos_x[i] = px + nx * depth;
+	pool->pos_y[i] = py + ny * depth;
+	f32 vn = pool->vel_x[i] * nx + pool->vel_y[i] * ny;
+	if (vn < 0.f) {
+		pool->vel_x[i] -= (1.f + collider->bounce) * vn * nx;
+		pool->vel_y[i] -= (1.f + collider->bounce) * vn * ny;
+	}
+}
+
+static void psys_sim_chunk(void* context, u32 index) {
+	psys_sim* sim = (psys_sim*) context;
+	psys_pool* pool = &sim->pool;
+	u32 start = index * SimChunkSize;
+	// Round up into the padding, the lanes past count are scratch
+	u32 end = Min((pool->count + PoolLanes - 1) & ~(PoolLanes - 1), start + SimChunkSize);
+	u32 n = end - start;
+	f32 dt = sim->dt;
+	
+	psys_integrate(pool->pos_x + start, pool->vel_x + start, dt, n);
+	psys_integrate(pool->pos_y + start, pool->vel_y + start, dt, n);
+	psys_integrate(pool->vel_x + start, pool->acc_x + start, dt, n);
+	psys_integrate(pool->vel_y + start, pool->acc_y + start, dt, n);
+	if (psys_emitter_has_repulsion(&sim->emitter) || psys_emitter_has_fields(&sim->emitter)) {
+		psys_integrate(pool->vel_x + start, sim->force_x + start, dt, n);
+		psys_integrate(pool->vel_y + start, sim->force_y + start, dt, n);
+	}
+	psys_integrate(pool->r + start, pool->dr + start, dt, n);
+	psys_integrate(pool->g + start, pool->dg + start, dt, n);
+	psys_integrate(pool->b + start, pool->db + start, dt, n);
+	psys_integrate(pool->a + start, pool->da + start, dt, n);
+	psys_age(pool->lifetime + start, dt, n);
+	
+	if (psys_emitter_has_colliders(&sim->emitter)) {
+		u32 live = Min(end, pool->count);
+		for (u32 c = 0; c < PsysMaxColliders; c++) {
+			if (sim->emitter.colliders[c].type == ColliderType_None) continue;
+			for (u32 i = start; i < live; i++) psys_collide(pool, &sim->emitter.colliders[c], i);
+		}
+	}
+}
+
+// Forces read every particle's position, so they're all worked out before anything moves
+static void psys_sim_step(psys_sim* sim) {
+	u32 count = sim->pool.count;
+	if (psys_emitter_has_repulsion(&sim->emitter) || psys_emitter_has_fields(&sim->emitter)) {
+		if (psys_emitter_has_repulsion(&sim->emitter)) psys_grid_build(sim);
+		psys_sim_run(sim, psys_force_chunk, (count + ForceChunkSize - 1) / ForceChunkSize);
+	}
+	psys_sim_run(sim, psys_sim_chunk, (count + SimChunkSize - 1) / SimChunkSize);
+	sim->time += sim->dt;
+}
+
+static void psys_sim_step_job(void* context, u32 index) {
+	psys_sim_step((psys_sim*) context);
+}
+
+// The emitter is copied so the sliders can keep moving while the step runs
+static void psys_sim_integrate(psys_sim* sim, psys_emitter* emitter, f32 dt) {
+	sim->dt = dt;
+	sim->emitter = *emitter;
+	J_Dispatch(&sim->group, psys_sim_step_job, sim, 1);
+}
+
+static psys_property_desc* psys_property_find(psys_property_id id) {
+	for (u32 i = 0; i < ArrayCount(psys_properties); i++)
+		if (psys_properties[i].id == id) return &psys_properties[i];
+	return nullptr;
+}
+
+// The emitter's block of properties, or an empty string if the file is damaged or too short
+// emitter_count as far as the file can back it up, the table can't run past the end
+static u32 psys_file_emitter_count(string file) {
+	if (file.size < sizeof(psys_header)) return 0;
+	psys_header* header = (psys_header*) file.str;
+	if (header->magic != PsysMagic || header->major != PsysVersionMajor) return 0;
+	if (header->table_offset > file.size) return 0;
+	u64 fits = (file.size - header->table_offset) / sizeof(psys_emitter_entry);
+	return (u32) Min((u64) header->emitter_count, fits);
+}
+
+static string psys_file_emitter(string file, u32 index) {
+	if (index >= psys_file_emitter_count(file)) return (string) {0};
+	psys_header* header = (psys_header*) file.str;
+	
+	u64 entry_at = (u64) header->table_offset + (u64) index * sizeof(psys_emitter_entry);
+	if (entry_at + sizeof(psys_emitter_entry) > file.size) return (string) {0};
+	psys_emitter_entry* entry = (psys_emitter_entry*) (file.str + entry_at);
+	if ((u64) entry->offset + entry->size > file.size || (entry->offset & 3)) return (string) {0};
+	return (string) { .str = file.str + entry->offset, .size = entry->size };
+}
+
+// Steps to the property at *at, false once the block ends or a property runs past it
+static b8 psys_block_next(string block, u64* at, psys_property** property, u32** values) {
+	if (*at + sizeof(psys_property) > block.size) return false;
+	psys_property* p = (psys_property*) (block.str + *at);
+	u64 size = sizeof(psys_property) + (u64) p->count * sizeof(u32);
+	if (*at + size > block.size) return false;
+	*property = p;
+	*values = (u32*) (p + 1);
+	*at += size;
+	return true;
+}
 
-#define ParticlePoolSize 128
-static psys_particle particles[ParticlePoolSize] = {0};
-static b8 particles_used[ParticlePoolSize] = {0};
+static u32 psys_pool_size_clamp(u32 pool_size) {
+	if (pool_size <= PsysMaxPoolSize) return pool_size;
+	LogError("A pool of %u particles is more than the %u supported, clamping it", pool_size, PsysMaxPoolSize);
+	return PsysMaxPoolSize;
+}
+
+static void psys_emitter_read(psys_emitter* emitter, string block) {
+	u64 at = 0;
+	psys_property* property;
+	u32* values;
+	while (psys_block_next(block, &at, &property, &values)) {
+		psys_property_desc* desc = psys_property_find(property->id);
+		if (!desc || desc->type != property->type) continue;
+		
+		if (desc->per_particle) {
+			// A property cut short by an older writer fills what it can
+			u32 blueprint = Min(property->count, desc->count);
+			u32 variance = property->count > desc->count ? Min(property->count - desc->count, desc->count) : 0;
+			memcpy((u8*) &emitter->blueprint + desc->offset, values, blueprint * sizeof(u32));
+			memcpy((u8*) &emitter->variance + desc->offset, values + desc->count, variance * sizeof(u32));
+		} else {
+			memcpy((u8*) emitter + desc->offset, values, Min(property->count, desc->count) * sizeof(u32));
+		}
+	}
+	emitter->pool_size = psys_pool_size_clamp(emitter->pool_size);
+}
+
+typedef struct psys_writer {
+	u8* base;
+	u32 size;
+} psys_writer;
+
+static void psys_write(psys_writer* w, void* bytes, u32 size) {
+	memcpy(w->base + w->size, bytes, size);
+	w->size += size;
+}
+
+static void psys_emitter_write(psys_writer* w, psys_emitter* emitter, string previous) {
+	for (u32 i = 0; i < ArrayCount(psys_properties); i++) {
+		psys_property_desc* desc = &psys_properties[i];
+		psys_property property = { desc->id, desc->type, desc->per_particle ? desc->count * 2 : desc->count };
+		psys_write(w, &property, sizeof(psys_property));
+		if (desc->per_particle) {
+			psys_write(w, (u8*) &emitter->blueprint + desc->offset, desc->count * sizeof(u32));
+			psys_write(w, (u8*) &emitter->variance + desc->offset, desc->count * sizeof(u32));
+		} else {
+			psys_write(w, (u8*) emitter + desc->offset, desc->count * sizeof(u32));
+		}
+	}
+	
+	// Whatever a newer version wrote goes back out untouched
+	u64 at = 0;
+	u64 start = 0;
+	psys_property* property;
+	u32* values;
+	while (psys_block_next(previous, &at, &property, &values)) {
+		if (!psys_property_find(property->id)) psys_write(w, previous.str + start, at - start);
+		start = at;
+	}
+}
+
+static void psys_file_save(string filepath) {
+	u32 emitter_count = 1;
+	if (psys_file_emitter(loaded, 0).str) emitter_count = psys_file_emitter_count(loaded);
+	
+	// Sized from the blocks that actually get copied. In a sound file they don't overlap and add up to
+	// less than the file, entries that share or overlap blocks can add up to far more, so anything past
+	// that point is dropped. The first emitter's known properties are a few hundred bytes on top
+	u64 blocks = 0;
+	for (u32 i = 0; i < emitter_count; i++) {
+		u64 size = psys_file_emitter(loaded, i).size;
+		if (blocks + size > loaded.size) {
+			LogError("%.*s has overlapping emitters, only the first %u are kept", str_expand(filepath), i);
+			emitter_count = i;
+			break;
+		}
+		blocks += size;
+	}
+	u64 cap = sizeof(psys_header) + (u64) emitter_count * sizeof(psys_emitter_entry) + blocks + Kilobytes(4);
+	psys_writer w = { .base = arena_alloc_zero(&arena, cap) };
+	
+	psys_header header = { PsysMagic, PsysVersionMajor, PsysVersionMinor, emitter_count, sizeof(psys_header) };
+	psys_write(&w, &header, sizeof(psys_header));
+	psys_emitter_entry* table = (psys_emitter_entry*) (w.base + w.size);
+	w.size += emitter_count * sizeof(psys_emitter_entry);
+	
+	// This editor only ever edits the first emitter of a library
+	table[0].offset = w.size;
+	psys_emitter_write(&w, &data, psys_file_emitter(loaded, 0));
+	table[0].size = w.size - table[0].offset;
+	for (u32 i = 1; i < emitter_count; i++) {
+		string block = psys_file_emitter(loaded, i);
+		table[i].offset = w.size;
+		psys_write(&w, block.str, block.size);
+		table[i].size = block.size;
+	}
+	
+	OS_FileCreateWrite(filepath, (string) { .str = w.base, .size = w.size });
+}
+
+// Appends count particles, each stream is filled in one go rather than a particle at a time.
+// The first one was emitted age seconds ago and each next one spacing seconds after it,
+// they're stepped forward by that much so nothing lines up on frame boundaries
+static void psys_spawn(psys_sim* sim, psys_emitter* emitter, u32 count, f32 age, f32 spacing) {
+	psys_pool* pool = &sim->pool;
+	u32 i = pool->count;
+	psys_particle* bp = &emitter->blueprint;
+	psys_particle* var = &emitter->variance;
+	RNG_BatchFillF32PM(&sim->rng, pool->pos_x + i, count, bp->pos.x, var->pos.x);
+	RNG_BatchFillF32PM(&sim->rng, pool->pos_y + i, count, bp->pos.y, var->pos.y);
+	RNG_BatchFillF32PM(&sim->rng, pool->vel_x + i, count, bp->vel.x, var->vel.x);
+	RNG_BatchFillF32PM(&sim->rng, pool->vel_y + i, count, bp->vel.y, var->vel.y);
+	RNG_BatchFillF32PM(&sim->rng, pool->acc_x + i, count, bp->acc.x, var->acc.x);
+	RNG_BatchFillF32PM(&sim->rng, pool->acc_y + i, count, bp->acc.y, var->acc.y);
+	RNG_BatchFillF32PM(&sim->rng, pool->r + i, count, bp->color.x, var->color.x);
+	RNG_BatchFillF32PM(&sim->rng, pool->g + i, count, bp->color.y, var->color.y);
+	RNG_BatchFillF32PM(&sim->rng, pool->b + i, count, bp->color.z, var->color.z);
+	RNG_BatchFillF32PM(&sim->rng, pool->a + i, count, bp->color.w, var->color.w);
+	RNG_BatchFillF32PM(&sim->rng, pool->dr + i, count, bp->color_vel.x, var->color_vel.x);
+	RNG_BatchFillF32PM(&sim->rng, pool->dg + i, count, bp->color_vel.y, var->color_vel.y);
+	RNG_BatchFillF32PM(&sim->rng, pool->db + i, count, bp->color_vel.z, var->color_vel.z);
+	RNG_BatchFillF32PM(&sim->rng, pool->da + i, count, bp->color_vel.w, var->color_vel.w);
+	RNG_BatchFillF32PM(&sim->rng, pool->lifetime + i, count, bp->lifetime, var->lifetime);
+	for (u32 k = i; k < i + count; k++) {
+		f32 t = age - (k - i) * spacing;
+		pool->size[k] = 10;
+		// Same order as the integration, position moves with the velocity from before it changes
+		pool->pos_x[k] += pool->vel_x[k] * t; pool->pos_y[k] += pool->vel_y[k] * t;
+		pool->vel_x[k] += pool->acc_x[k] * t; pool->vel_y[k] += pool->acc_y[k] * t;
+		pool->r[k] += pool->dr[k] * t; pool->g[k] += pool->dg[k] * t;
+		pool->b[k] += pool->db[k] * t; pool->a[k] += pool->da[k] * t;
+		pool->lifetime[k] -= t;
+	}
+	pool->count += count;
+}
+
+// Spawns everything due over the next dt seconds
+static void psys_emit(psys_sim* sim, psys_emitter* emitter, f32 dt) {
+	psys_pool* pool = &sim->pool;
+	
+	// Continuous stream, the fraction of a particle left over carries into the next frame
+	if (emitter->speed > 0.f) {
+		sim->timer += dt;
+		f32 due = floorf(sim->timer / emitter->speed);
+		// Whatever doesn't fit is dropped, same as spawning one at a time into a full pool
+		u32 count = (u32) Min(due, (f32) (pool->capacity - pool->count));
+		if (count) psys_spawn(sim, emitter, count, sim->timer - emitter->speed, emitter->speed);
+		sim->timer -= due * emitter->speed;
+	}
+	
+	if (emitter->burst_count && !sim->bursts_done) {
+		sim->burst_timer -= dt;
+		while (sim->burst_timer <= 0.f) {
+			u32 count = Min(emitter->burst_count, pool->capacity - pool->count);
+			if (count) psys_spawn(sim, emitter, count, -sim->burst_timer, 0.f);
+			if (emitter->burst_interval <= 0.f) {
+				sim->bursts_done = true;
+				break;
+			}
+			sim->burst_timer += emitter->burst_interval;
+		}
+	}
+}
+
+// Baking runs the emitter headless at a fixed step on the job system, as fast as the cores allow, and
+// keeps every BakeStepsPerFrame-th step as a keyframe. Keyframes decode on their own, so scrubbing to any
+// time is one frame's worth of work
+#define BakeStep (1.f / 60.f)
+#define BakeStepsPerFrame 2
+#define BakeDuration 120.f
+#define BakeMagic 0x4B414250
+#define BakeVersion 1
+// Worst case for one particle, three 16 bit streams at 3 bytes and four color channels at 2
+#define BakeMaxParticleBytes 17
+
+typedef struct psys_cache_header {
+	u32 magic;
+	u32 version;
+	u32 frame_count;
+	f32 frame_time;
+	u32 table_offset;
+} psys_cache_header;
+
+// A frame is its bounds, min x, min y, max x, max y and max size as f32, then varint streams of
+// x and y quantized to 16 bits inside the bounds, size to 16 bits of the max, and the four color bytes.
+// Streams are delta coded along the pool and zigzagged, so similar neighbours cost a byte each
+typedef struct psys_cache_frame {
+	u32 offset;
+	u32 size;
+	u32 count;
+} psys_cache_frame;
+
+typedef struct psys_bake {
+	// A copy, the sliders can keep moving while it runs
+	psys_emitter emitter;
+	psys_sim sim;
+	M_Arena arena;
+	// Encoded frames back to back, table offsets are from its start until the file is written
+	M_Arena frames;
+	psys_cache_frame* table;
+	u32 frame_count;
+	volatile i32 frames_done;
+	volatile i32 cancel;
+	volatile i32 done;
+	// Its own thread rather than a job, a two minute job would hold up whoever ends up running it
+	OS_Thread thread;
+	b8 running;
+} psys_bake;
+
+typedef struct psys_cache {
+	M_Arena arena;
+	string file;
+	psys_cache_header* header;
+	psys_cache_frame* table;
+	// Sized for the busiest frame
+	psys_instance* instances;
+	u32* decode;
+	u32 max_count;
+	u32 count;
+	u32 frame;
+	b8 valid;
+} psys_cache;
+
+static psys_bake bake = {0};
+static psys_cache cache = {0};
+static string bake_path = {0};
+static b8 playback = false;
+static f32 playback_time = 0.f;
+
+static u8* psys_varint_put(u8* out, u32 v) {
+	while (v >= 0x80) {
+		*out++ = (u8) v | 0x80;
+		v >>= 7;
+	}
+	*out++ = (u8) v;
+	return out;
+}
+
+// nullptr if the value runs past the end
+static u8* psys_varint_get(u8* in, u8* end, u32* v) {
+	u32 result = 0;
+	for (u32 shift = 0; shift < 35 && in < end; shift += 7) {
+		u8 byte = *in++;
+		result |= (u32) (byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			*v = result;
+			return in;
+		}
+	}
+	return nullptr;
+}
+
+static u8* psys_put_stream(u8* out, f32* values, u32 count, f32 min, f32 scale, u32 max_q) {
+	i32 prev = 0;
+	for (u32 i = 0; i < count; i++) {
+		i32 q = (i32) Clamp(0.f, (values[i] - min) * scale + 0.5f, (f32) max_q);
+		i32 delta = q - prev;
+		out = psys_varint_put(out, ((u32) delta << 1) ^ (u32) (delta >> 31));
+		prev = q;
+	}
+	return out;
+}
+
+static u8* psys_get_stream(u8* in, u8* end, u32 count, u32* q) {
+	i32 prev = 0;
+	for (u32 i = 0; i < count && in; i++) {
+		u32 z = 0;
+		in = psys_varint_get(in, end, &z);
+		prev += (i32) (z >> 1) ^ -(i32) (z & 1);
+		q[i] = (u32) prev;
+	}
+	return in;
+}
+
+static u32 psys_bake_encode(u8* out, psys_pool* pool) {
+	u32 n = pool->count;
+	f32 bounds[5] = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, 0.f };
+	for (u32 i = 0; i < n; i++) {
+		bounds[0] = Min(bounds[0], pool->pos_x[i]);
+		bounds[1] = Min(bounds[1], pool->pos_y[i]);
+		bounds[2] = Max(bounds[2], pool->pos_x[i]);
+		bounds[3] = Max(bounds[3], pool->pos_y[i]);
+		bounds[4] = Max(bounds[4], pool->size[i]);
+	}
+	if (!n) memset(bounds, 0, sizeof(bounds));
+	memcpy(out, bounds, sizeof(bounds));
+	
+	f32 sx = bounds[2] > bounds[0] ? 65535.f / (bounds[2] - bounds[0]) : 0.f;
+	f32 sy = bounds[3] > bounds[1] ? 65535.f / (bounds[3] - bounds[1]) : 0.f;
+	f32 ss = bounds[4] > 0.f ? 65535.f / bounds[4] : 0.f;
+	u8* at = out + sizeof(bounds);
+	at = psys_put_stream(at, pool->pos_x, n, bounds[0], sx, 65535);
+	at = psys_put_stream(at, pool->pos_y, n, bounds[1], sy, 65535);
+	at = psys_put_stream(at, pool->size, n, 0.f, ss, 65535);
+	at = psys_put_stream(at, pool->r, n, 0.f, 255.f, 255);
+	at = psys_put_stream(at, pool->g, n, 0.f, 255.f, 255);
+	at = psys_put_stream(at, pool->b, n, 0.f, 255.f, 255);
+	at = psys_put_stream(at, pool->a, n, 0.f, 255.f, 255);
+	return at - out;
+}
+
+static void psys_bake_run(psys_bake* b) {
+	psys_sim* sim = &b->sim;
+	u32 frame = 0;
+	for (u32 step = 0; frame < b->frame_count && !b->cancel; step++) {
+		// Same order as the editor, cull and spawn, keep what would be drawn, then integrate
+		psys_cull_dead(&sim->pool);
+		psys_emit(sim, &b->emitter, BakeStep);
+		
+		if (step % BakeStepsPerFrame == 0) {
+			u64 worst = sizeof(f32) * 5 + (u64) sim->pool.count * BakeMaxParticleBytes;
+			// Out of room, what's baked so far is still a usable cache. The editor says how much it got
+			if (b->frames.alloc_position + worst + sizeof(u64) > b->frames.max) {
+				LogError("Bake ran out of room after %.1fs of %.0fs", frame * BakeStep * BakeStepsPerFrame, BakeDuration);
+				break;
+			}
+			u8* out = arena_alloc(&b->frames, worst);
+			u32 size = psys_bake_encode(out, &sim->pool);
+			arena_dealloc(&b->frames, worst - size);
+			b->table[frame] = (psys_cache_frame) { (u32) (out - b->frames.memory), size, sim->pool.count };
+			frame++;
+			OS_AtomicIncrement(&b->frames_done);
+		}
+		
+		// Chunks go out to the workers, this thread helps while it waits
+		sim->dt = BakeStep;
+		sim->emitter = b->emitter;
+		psys_sim_step(sim);
+	}
+}
+
+static u32 psys_bake_thread(void* context) {
+	ThreadContext tctx = {0};
+	tctx_init(&tctx);
+	psys_bake* b = (psys_bake*) context;
+	psys_bake_run(b);
+	b->done = true;
+	tctx_free(&tctx);
+	return 0;
+}
+
+static void psys_bake_start(void) {
+	bake.emitter = data;
+	arena_init(&bake.arena);
+	arena_init(&bake.frames);
+	psys_sim_init(&bake.sim, &bake.arena, bake.emitter.pool_size);
+	bake.frame_count = (u32) (BakeDuration / (BakeStep * BakeStepsPerFrame));
+	bake.table = arena_alloc_zero(&bake.arena, sizeof(psys_cache_frame) * bake.frame_count);
+	bake.frames_done = 0;
+	bake.cancel = 0;
+	bake.done = 0;
+	bake.running = true;
+	bake.thread = OS_ThreadCreate(psys_bake_thread, &bake);
+}
+
+static void psys_cache_close(void) {
+	if (cache.arena.memory) arena_free(&cache.arena);
+	cache = (psys_cache) {0};
+}
+
+// Reads the whole cache in, but frames are only decoded when they're asked for
+static b8 psys_cache_open(string path) {
+	psys_cache_close();
+	if (!OS_FileExists(path)) return false;
+	arena_init(&cache.arena);
+	cache.file = OS_FileRead(&cache.arena, path);
+	
+	string file = cache.file;
+	psys_cache_header* header = (psys_cache_header*) file.str;
+	if (file.size < sizeof(psys_cache_header) || header->magic != BakeMagic || header->version != BakeVersion ||
+		(u64) header->table_offset + (u64) header->frame_count * sizeof(psys_cache_frame) > file.size ||
+		header->frame_time <= 0.f) {
+		LogError("%.*s is not a bake cache this version can read", str_expand(path));
+		psys_cache_close();
+		return false;
+	}
+	
+	psys_cache_frame* table = (psys_cache_frame*) (file.str + header->table_offset);
+	u32 max_count = 0;
+	for (u32 i = 0; i < header->frame_count; i++) {
+		// Every particle takes at least a byte per stream, which bounds the decode buffers
+		if ((u64) table[i].offset + table[i].size > file.size || (u64) table[i].count * 7 > table[i].size) {
+			LogError("%.*s has a damaged frame %u", str_expand(path), i);
+			psys_cache_close();
+			return false;
+		}
+		max_count = Max(max_count, table[i].count);
+	}
+	
+	cache.header = header;
+	cache.table = table;
+	cache.max_count = max_count;
+	cache.instances = arena_alloc(&cache.arena, sizeof(psys_instance) * Max(max_count, 1));
+	cache.decode = arena_alloc(&cache.arena, sizeof(u32) * Max(max_count, 1));
+	cache.frame = u32_max;
+	cache.valid = header->frame_count > 0;
+	return cache.valid;
+}
+
+static b8 psys_cache_decode(u32 index) {
+	if (index == cache.frame) return true;
+	psys_cache_frame* frame = &cache.table[index];
+	f32 bounds[5];
+	if (frame->size < sizeof(bounds)) return false;
+	u8* in = cache.file.str + frame->offset;
+	u8* end = in + frame->size;
+	memcpy(bounds, in, sizeof(bounds));
+	in += sizeof(bounds);
+	
+	u32 n = frame->count;
+	u32* q = cache.decode;
+	psys_instance* out = cache.instances;
+	f32 dx = (bounds[2] - bounds[0]) / 65535.f;
+	f32 dy = (bounds[3] - bounds[1]) / 65535.f;
+	f32 ds = bounds[4] / 65535.f;
+	
+	if (!(in = psys_get_stream(in, end, n, q))) return false;
+	for (u32 i = 0; i < n; i++) out[i].x = bounds[0] + q[i] * dx;
+	if (!(in = psys_get_stream(in, end, n, q))) return false;
+	for (u32 i = 0; i < n; i++) out[i].y = bounds[1] + q[i] * dy;
+	if (!(in = psys_get_stream(in, end, n, q))) return false;
+	for (u32 i = 0; i < n; i++) out[i].size = q[i] * ds;
+	for (u32 c = 0; c < 4; c++) {
+		if (!(in = psys_get_stream(in, end, n, q))) return false;
+		for (u32 i = 0; i < n; i++) {
+			u32 channel = (q[i] & 0xFF) << (c * 8);
+			out[i].color = c ? out[i].color | channel : channel;
+		}
+	}
+	cache.count = n;
+	cache.frame = index;
+	return true;
+}
+
+static void psys_bake_finish(void) {
+	OS_ThreadWaitForJoin(&bake.thread);
+	OS_ThreadRelease(&bake.thread);
+	u32 frame_count = (u32) bake.frames_done;
+	if (!bake.cancel && frame_count) {
+		u32 data_start = sizeof(psys_cache_header) + frame_count * sizeof(psys_cache_frame);
+		for (u32 i = 0; i < frame_count; i++) bake.table[i].offset += data_start;
+		psys_cache_header header = {
+			BakeMagic, BakeVersion, frame_count, BakeStep * BakeStepsPerFrame, sizeof(psys_cache_header)
+		};
+		
+		string_list list = {0};
+		string_list_push(&bake.arena, &list, (string) { (u8*) &header, sizeof(psys_cache_header) });
+		string_list_push(&bake.arena, &list, (string) { (u8*) bake.table, frame_count * sizeof(psys_cache_frame) });
+		string_list_push(&bake.arena, &list, (string) { bake.frames.memory, bake.frames.alloc_position });
+		OS_FileCreateWrite_List(bake_path, list);
+	}
+	arena_free(&bake.arena);
+	arena_free(&bake.frames);
+	bake.running = false;
+	if (!bake.cancel) psys_cache_open(bake_path);
+}
+
+static void psys_emitter_defaults(psys_emitter* emitter) {
+	*emitter = (psys_emitter) {0};
+	emitter->blueprint = (psys_particle) {
+		.pos = (vec2) { 0.f, 0.f },
+		.vel = (vec2) { 0.f, -50.f },
+		.acc = (vec2) { 0.f, 50.f },
+		.color = Color_Red,
+		.color_vel = (vec4) { 0.f, 0.f, 0.f, 0.f },
+		.lifetime = 4.f
+	};
+	emitter->variance = (psys_particle) {
+		.pos = (vec2) { 0.f, 0.f },
+		.vel = (vec2) { 10.f, 2.f },
+		.acc = (vec2) { 0.f, 2.f },
+		.color = (vec4) { 0.1f, 0.0f, 0.02f, 0.f },
+		.color_vel = (vec4) { 0.f, 0.f, 0.f, 0.f },
+		.lifetime = 0.1f
+	};
+	emitter->speed = 0.1f;
+	emitter->pool_size = DefaultPoolSize;
+}
+
+// Everything on the emitter that can change while it runs. The pool size only takes effect on open,
+// so it stays out of the grid
+#define PsysField(label, kind, count, member, min, max)\
+{ { (u8*) label, sizeof(label) - 1 }, kind, count, offsetof(psys_emitter, member), min, max }
+
+#define PsysParticleFields(label, member, range)\
+PsysField(label " position", FieldKind_F32, 2, member.pos, -range, range),\
+PsysField(label " velocity", FieldKind_F32, 2, member.vel, -range, range),\
+PsysField(label " acceleration", FieldKind_F32, 2, member.acc, -range, range),\
+PsysField(label " color", FieldKind_F32, 4, member.color, 0.f, 1.f),\
+PsysField(label " color change", FieldKind_F32, 4, member.color_vel, -1.f, 1.f),\
+PsysField(label " lifetime", FieldKind_F32, 1, member.lifetime, 0.f, 10.f)
+
+// Type is a psys_field_type, 0 turns it off
+#define PsysForceFieldFields(label, i)\
+PsysField(label " type", FieldKind_U32, 1, fields[i].type, 0.f, 3.f),\
+PsysField(label " position", FieldKind_F32, 2, fields[i].pos, -400.f, 400.f),\
+PsysField(label " strength", FieldKind_F32, 1, fields[i].strength, -500.f, 500.f),\
+PsysField(label " radius", FieldKind_F32, 1, fields[i].radius, 0.f, 400.f)
+
+// Type is a psys_collider_type, 0 turns it off
+#define PsysColliderFields(label, i)\
+PsysField(label " type", FieldKind_U32, 1, colliders[i].type, 0.f, 2.f),\
+PsysField(label " position", FieldKind_F32, 2, colliders[i].pos, -400.f, 400.f),\
+PsysField(label " normal", FieldKind_F32, 2, colliders[i].normal, -1.f, 1.f),\
+PsysField(label " radius", FieldKind_F32, 1, colliders[i].radius, 0.f, 400.f),\
+PsysField(label " bounce", FieldKind_F32, 1, colliders[i].bounce, 0.f, 1.f)
+
+static UI_PropertyField emitter_fields[] = {
+	PsysParticleFields("Blueprint", blueprint, 200.f),
+	PsysParticleFields("Variance", variance, 200.f),
+	PsysField("Spawn interval", FieldKind_F32, 1, speed, 0.f, 0.5f),
+	PsysField("Burst count", FieldKind_U32, 1, burst_count, 0.f, 10000.f),
+	PsysField("Burst interval", FieldKind_F32, 1, burst_interval, 0.f, 10.f),
+	PsysField("Repulsion strength", FieldKind_F32, 1, repulsion, 0.f, 2000.f),
+	PsysField("Repulsion radius", FieldKind_F32, 1, repulsion_radius, 0.f, 50.f),
+	PsysForceFieldFields("Field 1", 0),
+	PsysForceFieldFields("Field 2", 1),
+	PsysForceFieldFields("Field 3", 2),
+	PsysForceFieldFields("Field 4", 3),
+	PsysColliderFields("Collider 1", 0),
+	PsysColliderFields("Collider 2", 1),
+	PsysColliderFields("Collider 3", 2),
+	PsysColliderFields("Collider 4", 3),
+};
+static UI_PropertyGrid emitter_grid = {0};
 
 dll_export string_array Extensions(M_Arena* arena) {
 	string exts[] = {
@@ -37,147 +1268,173 @@ dll_export string_array Extensions(M_Arena* arena) {
 	return string_static_array_make(arena, exts, 1);
 }
 
-f32 random_float_pm(f32 r) {
-	srand(OS_TimeMicrosecondsNow() * 2654435761);
-	f32 zerotoone = (f32)rand() / (f32)RAND_MAX;
-	f32 minusonetoone = (zerotoone - 0.5f) * 2.f;
-	return minusonetoone * r;
+// Buffer storage is immutable on some backends, so growing means recreating it and the pipeline using it
+static void psys_instance_buffer_reserve(u32 count) {
+	if (count <= instance_capacity) return;
+	if (instance_capacity) {
+		R_PipelineFree(&instance_pipeline);
+		R_BufferFree(&instance_buffer);
+	}
+	R_BufferAlloc(&instance_buffer, BufferFlag_Dynamic | BufferFlag_Type_Vertex);
+	R_BufferData(&instance_buffer, sizeof(psys_instance) * count, nullptr);
+	R_PipelineAlloc(&instance_pipeline, InputAssembly_Triangles, instance_attributes, ArrayCount(instance_attributes), &instance_shader);
+	R_PipelineAddInstanceBuffer(&instance_pipeline, &instance_buffer, ArrayCount(instance_attributes), 1);
+	instance_capacity = count;
 }
 
 dll_export void Init(string filepath) {
-	MemoryZero(particles_used, ParticlePoolSize * sizeof(b8));
 	UI_SetColorProperty(ColorProperty_Slider_Base, (vec4) { 0.4f, 0.4f, 0.4f, 1.f });
 	UI_SetColorProperty(ColorProperty_Slider_BobBase, (vec4) { 0.5f, 0.5f, 0.5f, 1.f });
 	UI_SetColorProperty(ColorProperty_Slider_BobHover, (vec4) { 0.6f, 0.6f, 0.6f, 1.f });
 	UI_SetColorProperty(ColorProperty_Slider_BobDrag, (vec4) { 0.3f, 0.3f, 0.3f, 1.f });
 	arena_init(&arena);
+	// The simulation never settles, so keep frames coming while it's open
+	F_RequestContinuous(true);
 	fp = filepath;
-	string strdata = OS_FileRead(&arena, filepath);
-	if (strdata.size == sizeof(psys_file)) {
-		memmove(&data, strdata.str, sizeof(psys_file));
-	} else {
-		data.blueprint = (psys_particle) {
-			.pos = (vec2) { 0.f, 0.f },
-			.vel = (vec2) { 0.f, -50.f },
-			.acc = (vec2) { 0.f, 50.f },
-			.color = Color_Red,
-			.color_vel = (vec4) { 0.f, 0.f, 0.f, 0.f },
-			.lifetime = 4.f
-		};
-		data.variance = (psys_particle) {
-			.pos = (vec2) { 0.f, 0.f },
-			.vel = (vec2) { 10.f, 2.f },
-			.acc = (vec2) { 0.f, 2.f },
-			.color = (vec4) { 0.1f, 0.0f, 0.02f, 0.f },
-			.color_vel = (vec4) { 0.f, 0.f, 0.f, 0.f },
-			.lifetime = 0.1f
-		};
-		data.speed = 0.1f;
+	psys_emitter_defaults(&data);
+	UI_PropertyGridInit(&emitter_grid, emitter_fields, ArrayCount(emitter_fields), 32.f);
+	
+	loaded = OS_FileRead(&arena, filepath);
+	string block = psys_file_emitter(loaded, 0);
+	if (block.str) {
+		psys_emitter_read(&data, block);
+	} else if (loaded.size == sizeof(psys_legacy_file) || loaded.size == offsetof(psys_legacy_file, burst_count) ||
+			   loaded.size == offsetof(psys_legacy_file, pool_size)) {
+		psys_legacy_file legacy = {0};
+		memcpy(&legacy, loaded.str, loaded.size);
+		data.blueprint = legacy.blueprint;
+		data.variance = legacy.variance;
+		data.speed = legacy.speed;
+		data.pool_size = psys_pool_size_clamp(legacy.pool_size);
+		data.burst_count = legacy.burst_count;
+		data.burst_interval = legacy.burst_interval;
+		// Nothing in it to carry over, the next save writes it out in the current format
+		loaded = (string) {0};
+	} else if (loaded.size) {
+		LogError("%.*s isn't a particle system file this version can read, starting from defaults", str_expand(filepath));
+		loaded = (string) {0};
 	}
+	if (!data.pool_size) data.pool_size = DefaultPoolSize;
+	psys_sim_init(&sim, &arena, data.pool_size);
+	instances = arena_alloc(&arena, sizeof(psys_instance) * sim.pool.capacity);
+	instance_count = 0;
+	
+	R_ShaderPackAllocLoad(&instance_shader, str_lit("res/particles"));
+	u_projection = R_ShaderPackGetUniform(&instance_shader, str_lit("u_projection"));
+	u_offset = R_ShaderPackGetUniform(&instance_shader, str_lit("u_offset"));
+	
+	bake_path = str_from_format(&arena, "%.*s.bake", str_expand(filepath));
+	psys_cache_open(bake_path);
+	playback = false;
+	playback_time = 0.f;
+	
+	instance_capacity = 0;
+	psys_instance_buffer_reserve(Max(sim.pool.capacity, cache.max_count));
 }
 
 dll_export void Update(f32 dt) {
-	timer += dt;
-	if (timer >= data.speed) {
-		for (u32 i = 0; i < ParticlePoolSize; i++) {
-			if (!particles_used[i]) {
-				particles_used[i] = true;
-				particles[i] = (psys_particle) {
-					.pos = (vec2) {
-						data.blueprint.pos.x + random_float_pm(data.variance.pos.x),
-						data.blueprint.pos.y + random_float_pm(data.variance.pos.y),
-					},
-					.vel = (vec2) {
-						data.blueprint.vel.x + random_float_pm(data.variance.vel.x),
-						data.blueprint.vel.y + random_float_pm(data.variance.vel.y),
-					},
-					.acc = (vec2) {
-						data.blueprint.acc.x + random_float_pm(data.variance.acc.x),
-						data.blueprint.acc.y + random_float_pm(data.variance.acc.y),
-					},
-					.color = (vec4) {
-						data.blueprint.color.x + random_float_pm(data.variance.color.x),
-						data.blueprint.color.y + random_float_pm(data.variance.color.y),
-						data.blueprint.color.z + random_float_pm(data.variance.color.z),
-						data.blueprint.color.w + random_float_pm(data.variance.color.w),
-					},
-					.color_vel = (vec4) {
-						data.blueprint.color_vel.x + random_float_pm(data.variance.color_vel.x),
-						data.blueprint.color_vel.y + random_float_pm(data.variance.color_vel.y),
-						data.blueprint.color_vel.z + random_float_pm(data.variance.color_vel.z),
-						data.blueprint.color_vel.w + random_float_pm(data.variance.color_vel.w),
-					},
-					.lifetime = data.blueprint.lifetime + random_float_pm(data.variance.lifetime),
-				};
-				break;
-			}
-		}
-		timer = 0.f;
-	}
-	
-	for (u32 i = 0; i < ParticlePoolSize; i++) {
-		if (particles_used[i]) {
-			particles[i].pos.x += particles[i].vel.x * dt;
-			particles[i].pos.y += particles[i].vel.y * dt;
-			particles[i].vel.x += particles[i].acc.x * dt;
-			particles[i].vel.y += particles[i].acc.y * dt;
-			particles[i].color.x += particles[i].color_vel.x * dt;
-			particles[i].color.y += particles[i].color_vel.y * dt;
-			particles[i].color.z += particles[i].color_vel.z * dt;
-			particles[i].color.w += particles[i].color_vel.w * dt;
-			
-			particles[i].lifetime -= dt;
-			if (particles[i].lifetime <= 0.f) {
-				particles_used[i] = false;
-			}
-		}
+	if (bake.running && bake.done) psys_bake_finish();
+	
+	// Last frame's integration has to land before anything is culled or spawned.
+	// Both stay on this thread so the pool order, and so the sim, is the same on any core count
+	J_Wait(&sim.group);
+	
+	// The live sim holds still while a bake plays back
+	if (playback && cache.valid) {
+		f32 duration = cache.header->frame_count * cache.header->frame_time;
+		playback_time = fmodf(playback_time + dt, duration);
+		return;
 	}
+	psys_cull_dead(&sim.pool);
+	psys_emit(&sim, &data, dt);
+	sim.dt = dt;
 }
 
 dll_export void Render(R2D_Renderer* renderer) {
-	UI_Label((vec2) { 10, 40 }, str_lit("Blueprint: "));
-	UI_Slider((rect) { 200, 40, 100, 5 }, (vec2) { 10, 20 }, -200.f, 200.f, &data.blueprint.pos.x);
-	UI_Label((vec2) { 200, 30 }, str_lit("x"));
-	UI_Slider((rect) { 310, 40, 100, 5 }, (vec2) { 10, 20 }, -200.f, 200.f, &data.blueprint.pos.y);
-	UI_Label((vec2) { 310, 30 }, str_lit("y"));
-	UI_Slider((rect) { 420, 40, 100, 5 }, (vec2) { 10, 20 }, 0.f, 1.f, &data.blueprint.color.x);
-	UI_Label((vec2) { 420, 30 }, str_lit("r"));
-	UI_Slider((rect) { 530, 40, 100, 5 }, (vec2) { 10, 20 }, 0.f, 1.f, &data.blueprint.color.y);
-	UI_Label((vec2) { 530, 30 }, str_lit("g"));
-	UI_Slider((rect) { 640, 40, 100, 5 }, (vec2) { 10, 20 }, 0.f, 1.f, &data.blueprint.color.z);
-	UI_Label((vec2) { 640, 30 }, str_lit("b"));
-	UI_Slider((rect) { 750, 40, 100, 5 }, (vec2) { 10, 20 }, 0.f, 1.f, &data.blueprint.color.w);
-	UI_Label((vec2) { 750, 30 }, str_lit("a"));
-	
-	UI_Label((vec2) { 10, 80 }, str_lit("Variance: "));
-	UI_Slider((rect) { 200, 80, 100, 5 }, (vec2) { 10, 20 }, -200.f, 200.f, &data.variance.pos.x);
-	UI_Label((vec2) { 200, 70 }, str_lit("x"));
-	UI_Slider((rect) { 310, 80, 100, 5 }, (vec2) { 10, 20 }, -200.f, 200.f, &data.variance.pos.y);
-	UI_Label((vec2) { 310, 70 }, str_lit("y"));
-	UI_Slider((rect) { 420, 80, 100, 5 }, (vec2) { 10, 20 }, 0.f, 1.f, &data.variance.color.x);
-	UI_Label((vec2) { 420, 70 }, str_lit("r"));
-	UI_Slider((rect) { 530, 80, 100, 5 }, (vec2) { 10, 20 }, 0.f, 1.f, &data.variance.color.y);
-	UI_Label((vec2) { 530, 70 }, str_lit("g"));
-	UI_Slider((rect) { 640, 80, 100, 5 }, (vec2) { 10, 20 }, 0.f, 1.f, &data.variance.color.z);
-	UI_Label((vec2) { 640, 70 }, str_lit("b"));
-	UI_Slider((rect) { 750, 80, 100, 5 }, (vec2) { 10, 20 }, 0.f, 1.f, &data.variance.color.w);
-	UI_Label((vec2) { 750, 70 }, str_lit("a"));
-	
-	vec2 old_offset = R2D_PushOffset(renderer, (vec2) { 400.f, 400.f });
-	for (u32 i = 0; i < ParticlePoolSize; i++) {
-		if (particles_used[i]) {
-			R2D_DrawQuadC(renderer, (rect) { particles[i].pos.x, particles[i].pos.y, 10, 10 },
-						  particles[i].color, 1);
+	if (UI_ButtonLabeled((rect) { 10, 10, 150, 30 }, str_lit("Bake")) && !bake.running) psys_bake_start();
+	if (bake.running) {
+		M_Scratch scratch = scratch_get();
+		u32 percent = (u32) bake.frames_done * 100 / Max(bake.frame_count, 1);
+		UI_Label((vec2) { 180, 30 }, str_from_format(&scratch.arena, "Baking %u%%", percent));
+		scratch_return(&scratch);
+	} else if (cache.valid) {
+		UI_Checkbox((rect) { 180, 12, 25, 25 }, &playback);
+		UI_Label((vec2) { 215, 30 }, str_lit("Playback"));
+		f32 duration = cache.header->frame_count * cache.header->frame_time;
+		UI_Slider((rect) { 340, 25, 400, 5 }, (vec2) { 10, 20 }, 0.f, duration, &playback_time);
+		// A bake that filled its memory stops early, say so rather than pass it off as the whole thing
+		if (duration < BakeDuration - cache.header->frame_time) {
+			M_Scratch scratch = scratch_get();
+			UI_Label((vec2) { 760, 30 }, str_from_format(&scratch.arena, "Only %.1fs of %.0fs fit", duration, BakeDuration));
+			scratch_return(&scratch);
+		}
+	}
+	
+	UI_PropertyGridEdit((rect) { renderer->render_size.x - 560, 50, 550, renderer->render_size.y - 60 }, &emitter_grid, &data);
+	
+	// Drawn in CustomRender, under the UI, with the same projection R2D uses
+	projection = mat4_transpose(mat4_ortho(0, renderer->render_size.x, 0, renderer->render_size.y, -1, 1000));
+	offset = vec2_add(renderer->offset, (vec2) { 400.f, 400.f });
+	
+	if (playback && cache.valid) {
+		u32 frame = Min((u32) (playback_time / cache.header->frame_time), cache.header->frame_count - 1);
+		if (!psys_cache_decode(frame)) {
+			LogError("Frame %u of the bake cache is damaged", frame);
+			playback = false;
 		}
+		drawn = cache.instances;
+		instance_count = cache.count;
+		return;
 	}
-	R2D_PopOffset(renderer, old_offset);
+	
+	// Only matters if Render runs twice without an Update in between
+	J_Wait(&sim.group);
+	
+	// One slice per worker plus the main thread, which helps out while it waits
+	psys_pack_job jobs[PackJobCount];
+	u32 job_count = Clamp(1, J_WorkerCount() + 1, PackJobCount);
+	// Slices start on a multiple of 4 so the vector loop never straddles two of them
+	u32 slice = (sim.pool.count / job_count) & ~3;
+	for (u32 t = 0; t < job_count; t++) {
+		jobs[t] = (psys_pack_job) {
+			.pool = &sim.pool,
+			.start = t * slice,
+			.end = t == job_count - 1 ? sim.pool.count : (t + 1) * slice,
+		};
+	}
+	J_Group pack_group = {0};
+	J_Dispatch(&pack_group, psys_pack_range, jobs, job_count);
+	J_Wait(&pack_group);
+	drawn = instances;
+	instance_count = sim.pool.count;
+	
+	// The records are copies, so the pool is free to move on while the frame is drawn
+	psys_sim_integrate(&sim, &data, sim.dt);
+}
+
+dll_export void CustomRender(void) {
+	if (!instance_count) return;
+	// Only grows if a new bake has a busier frame than the pool holds
+	psys_instance_buffer_reserve(instance_count);
+	R_BufferUpdate(&instance_buffer, 0, sizeof(psys_instance) * instance_count, drawn);
+	R_PipelineBind(&instance_pipeline);
+	R_UniformUploadMat4(u_projection, projection);
+	R_UniformUploadVec4(u_offset, (vec4) { offset.x, offset.y, 0.f, 0.f });
+	R_BlendAlpha();
+	R_DrawInstanced(&instance_pipeline, 0, 6, instance_count);
 }
 
 dll_export void Free() {
-	string packed_data = {
-		.str = (u8*) &data,
-		.size = sizeof(psys_file),
-	};
-	OS_FileWrite(fp, packed_data);
+	J_Wait(&sim.group);
+	if (bake.running) {
+		bake.cancel = true;
+		psys_bake_finish();
+	}
+	psys_cache_close();
+	psys_file_save(fp);
+	R_PipelineFree(&instance_pipeline);
+	R_BufferFree(&instance_buffer);
+	R_ShaderPackFree(&instance_shader);
 	arena_free(&arena);
+	F_RequestContinuous(false);
 }
@@ -7,6 +7,7 @@
 #include "opt/ui.h"
 #include "os/input.h"
 #include "core/helpers.h"
+#include "core/frame.h"
 #include <stdio.h>
 #include <math.h>
 
@@ -44,6 +45,7 @@ void Camera3DControls(Camera3D* cam, f32 dt) {
     cam->target_zoom += zoom_level;
     cam->target_zoom = Clamp(-20.f, cam->target_zoom, 0.f);
     animate_f32exp(&cam->zoom, cam->target_zoom, 10, dt);
+    if (fabsf(cam->zoom - cam->target_zoom) > 0.001f) F_RequestRedraw();
     
     if (OS_InputButton(Input_MouseButton_Left)) {
         f32 pitch_change = OS_InputGetMouseDY() * dt * 0.4f;
@@ -101,17 +103,33 @@ typedef struct LineVertex {
     vec4 color;
 } LineVertex;
 
+// Per-frame constants shared by both 3D shaders, bound at CAMERA_BINDING
+#define CAMERA_BINDING 0
+typedef struct CameraBlock {
+    mat4 projection;
+    mat4 view;
+} CameraBlock;
+
+// Per-instance attributes of the sphere pipeline, drawn in one instanced call
+typedef struct SphereInstance {
+    mat4 transform;
+    vec4 color;
+    i32 id;
+} SphereInstance;
+
 typedef struct solid_state_State {
     PackingType curr_type;
     
     R_ShaderPack three_dim;
     R_ShaderPack three_dim_lines;
+    R_Buffer camera_buffer;
+    R_Uniform two_dim_tex;
     R_Buffer sphere_buffer;
     R_Pipeline sphere_vertex_array;
     u32 sphere_vertex_count;
+    R_Buffer sphere_instance_buffer;
+    SphereInstance sphere_instances[OBJECT_COUNT];
     
-    R_Pipeline* objects[OBJECT_COUNT];
-    u32 obj_v_count[OBJECT_COUNT];
     mat4 obj_transforms[OBJECT_COUNT];
     vec4 obj_colors[OBJECT_COUNT];
     
@@ -124,10 +142,9 @@ typedef struct solid_state_State {
     R_Buffer fullscreen_buffer;
     R_Pipeline fullscreen_vertex_array;
     
-    R_Framebuffer fbo;
-    R_Texture2D fbo_color0;
-    R_Texture2D fbo_color1;
-    R_Texture2D fbo_depth;
+    R_Framebuffer* fbo;
+    R_Readback pick_readback;
+    R_CommandBuffer scene_cmds;
     
     u32 framebuffer_width;
     u32 framebuffer_height;
@@ -141,6 +158,19 @@ typedef struct solid_state_State {
 
 static solid_state_State v_solid_state_state = {0};
 
+// Color, object ids for picking, and depth. Pooled, so switching back to this plugin reuses it
+static R_RenderTargetDesc SceneTargetDesc(u32 width, u32 height) {
+    R_RenderTargetDesc desc = {0};
+    desc.width = width;
+    desc.height = height;
+    desc.color_formats[0] = TextureFormat_RGBA;
+    desc.color_formats[1] = TextureFormat_RInteger;
+    desc.color_count = 2;
+    desc.depth = true;
+    desc.filter = TextureResize_Nearest;
+    return desc;
+}
+
 void PushLine(vec3 a, vec3 b, vec4 c) {
     v_solid_state_state.lines_data[v_solid_state_state.line_v_count].pos = a;
     v_solid_state_state.lines_data[v_solid_state_state.line_v_count++].color = c;
@@ -338,30 +368,35 @@ dll_export void Init(string filepath) {
     v_solid_state_state.selected_obj_id = 0;
     v_solid_state_state.framebuffer_width = 1080;
     v_solid_state_state.framebuffer_height = 720;
-	R_Texture2DAlloc(&v_solid_state_state.fbo_color0, TextureFormat_RGBA, 1080, 720, TextureResize_Nearest, TextureResize_Nearest, TextureWrap_Repeat, TextureWrap_Repeat);
-	R_Texture2DAlloc(&v_solid_state_state.fbo_color1, TextureFormat_RInteger, 1080, 720, TextureResize_Nearest, TextureResize_Nearest, TextureWrap_Repeat, TextureWrap_Repeat);
-	R_Texture2DAlloc(&v_solid_state_state.fbo_depth, TextureFormat_DepthStencil, 1080, 720, TextureResize_Nearest, TextureResize_Nearest, TextureWrap_Repeat, TextureWrap_Repeat);
-    R_Texture2D color_attachments[] = {
-        v_solid_state_state.fbo_color0,
-        v_solid_state_state.fbo_color1,
-    };
-	R_FramebufferCreate(&v_solid_state_state.fbo, 1080, 720, color_attachments, 2, v_solid_state_state.fbo_depth);
+    R_RenderTargetDesc scene_desc = SceneTargetDesc(1080, 720);
+	v_solid_state_state.fbo = R_RenderTargetAcquire(&scene_desc);
+    R_ReadbackAlloc(&v_solid_state_state.pick_readback, sizeof(i32));
     
 	R_ShaderPackAllocLoad(&v_solid_state_state.three_dim, str_lit("res/three_dim"));
     R_ShaderPackAllocLoad(&v_solid_state_state.three_dim_lines, str_lit("res/three_dim_lines"));
     R_ShaderPackAllocLoad(&v_solid_state_state.two_dim, str_lit("res/two_dim"));
     
+    v_solid_state_state.two_dim_tex = R_ShaderPackGetUniform(&v_solid_state_state.two_dim, str_lit("u_tex"));
+    
+    R_ShaderPackBindUniformBlock(&v_solid_state_state.three_dim, str_lit("Camera"), CAMERA_BINDING);
+    R_ShaderPackBindUniformBlock(&v_solid_state_state.three_dim_lines, str_lit("Camera"), CAMERA_BINDING);
+    CameraBlock camera = { data.projection, Camera3DView(&data.cam) };
+    R_BufferAlloc(&v_solid_state_state.camera_buffer, BufferFlag_Type_Uniform | BufferFlag_Dynamic);
+    R_BufferData(&v_solid_state_state.camera_buffer, sizeof(CameraBlock), &camera);
+    
     v_solid_state_state.sphere_buffer = H_LoadObjToBufferVN(str_lit("res/ball.obj"), &v_solid_state_state.sphere_vertex_count);
-    R_Attribute threedim_attribs[] = { Attribute_Float3, Attribute_Float3 };
-	R_PipelineAlloc(&v_solid_state_state.sphere_vertex_array, InputAssembly_Triangles, threedim_attribs, 2, &v_solid_state_state.three_dim);
+    R_BufferAlloc(&v_solid_state_state.sphere_instance_buffer, BufferFlag_Type_Vertex | BufferFlag_Dynamic);
+    R_BufferData(&v_solid_state_state.sphere_instance_buffer, sizeof(v_solid_state_state.sphere_instances), nullptr);
+    R_Attribute threedim_attribs[] = {
+        Attribute_Float3, Attribute_Float3,
+        Attribute_Float4, Attribute_Float4, Attribute_Float4, Attribute_Float4, Attribute_Float4, Attribute_Integer1
+    };
+	R_PipelineAlloc(&v_solid_state_state.sphere_vertex_array, InputAssembly_Triangles, threedim_attribs, 8, &v_solid_state_state.three_dim);
     R_PipelineAddBuffer(&v_solid_state_state.sphere_vertex_array, &v_solid_state_state.sphere_buffer, 2);
-	R_PipelineBind(&v_solid_state_state.sphere_vertex_array);
-	R_ShaderPackUploadMat4(&v_solid_state_state.three_dim, str_lit("u_projection"), data.projection);
+    R_PipelineAddInstanceBuffer(&v_solid_state_state.sphere_vertex_array, &v_solid_state_state.sphere_instance_buffer, 6, 1);
 	
 	
 	for (u32 i = 0; i < OBJECT_COUNT; i++) {
-		v_solid_state_state.objects[i] = &v_solid_state_state.sphere_vertex_array;
-		v_solid_state_state.obj_v_count[i] = v_solid_state_state.sphere_vertex_count;
 		v_solid_state_state.obj_colors[i] = (vec4) { 0.2f, 0.3f, 0.8f, 0.8f };
 	}
 	
@@ -414,51 +449,70 @@ dll_export void Init(string filepath) {
 	R_PipelineAlloc(&v_solid_state_state.lines_vertex_array, InputAssembly_Lines, threedimlines_attribs, 2, &v_solid_state_state.three_dim_lines);
 	R_PipelineAddBuffer(&v_solid_state_state.lines_vertex_array, &v_solid_state_state.lines_buffer, 2);
 	R_PipelineBind(&v_solid_state_state.lines_vertex_array);
-	R_ShaderPackUploadMat4(&v_solid_state_state.three_dim_lines, str_lit("u_projection"), data.projection);
 	R_ShaderPackUploadMat4(&v_solid_state_state.three_dim_lines, str_lit("u_transform"), mat4_identity());
 	
 }
 
-dll_export void CustomRender(void) {
-	R_FramebufferBind(&v_solid_state_state.fbo);
-    R_BlendAlpha();
-    R_Clear(BufferMask_Color | BufferMask_Depth);
-    R_DepthEnable();
+// Recorded rather than issued directly, so the stream can be captured and replayed on its own
+static void SceneRecord(R_CommandBuffer* cmd) {
+    R_CmdBlendAlpha(cmd);
+    R_CmdClear(cmd, BufferMask_Color | BufferMask_Depth);
+    R_CmdDepthEnable(cmd);
     
     // Move to render.c api
-    R_Cull(CullFace_Back);
+    R_CmdCull(cmd, CullFace_Back);
+    
+    CameraBlock camera = { data.projection, Camera3DView(&data.cam) };
+    R_CmdBufferUpdate(cmd, &v_solid_state_state.camera_buffer, 0, sizeof(CameraBlock), &camera);
+    R_CmdBufferBindUniform(cmd, &v_solid_state_state.camera_buffer, CAMERA_BINDING);
     
-    R_PipelineBind(v_solid_state_state.objects[0]);
-    mat4 view = Camera3DView(&data.cam);
-    R_ShaderPackUploadMat4(&v_solid_state_state.three_dim, str_lit("u_view"), view);
     for (u32 i = 0; i < OBJECT_COUNT; i++) {
-        R_PipelineBind(v_solid_state_state.objects[i]);
-        R_ShaderPackUploadMat4(&v_solid_state_state.three_dim, str_lit("u_transform"),
-							   v_solid_state_state.obj_transforms[i]);
+        SphereInstance* instance = &v_solid_state_state.sphere_instances[i];
+        instance->transform = v_solid_state_state.obj_transforms[i];
         vec4 c = v_solid_state_state.obj_colors[i];
         c = v_solid_state_state.selected_obj_id == i + 1 ? vec4_add(c, vec4_init(0.15f, 0.15f, 0.15f, 0.0f)) : c;
-        R_ShaderPackUploadVec4(&v_solid_state_state.three_dim, str_lit("u_color"), c);
-        
-        R_ShaderPackUploadInt(&v_solid_state_state.three_dim, str_lit("u_id"), i + 1);
-        R_Draw(v_solid_state_state.objects[i], 0, v_solid_state_state.obj_v_count[i]);
+        instance->color = c;
+        instance->id = i + 1;
     }
+    R_CmdBufferUpdate(cmd, &v_solid_state_state.sphere_instance_buffer, 0, sizeof(v_solid_state_state.sphere_instances),
+                      v_solid_state_state.sphere_instances);
     
-    R_PipelineBind(&v_solid_state_state.lines_vertex_array);
-    R_ShaderPackUploadMat4(&v_solid_state_state.three_dim_lines, str_lit("u_view"), view);
-    R_Draw(&v_solid_state_state.lines_vertex_array, 0, v_solid_state_state.line_v_count);
+    R_CmdPipelineBind(cmd, &v_solid_state_state.sphere_vertex_array);
+    R_CmdDrawInstanced(cmd, &v_solid_state_state.sphere_vertex_array, 0, v_solid_state_state.sphere_vertex_count, OBJECT_COUNT);
     
-    R_Cull(CullFace_None);
-	
-    R_FramebufferBindScreen();
+    R_CmdPipelineBind(cmd, &v_solid_state_state.lines_vertex_array);
+    R_CmdDraw(cmd, &v_solid_state_state.lines_vertex_array, 0, v_solid_state_state.line_v_count);
+    
+    R_CmdCull(cmd, CullFace_None);
+}
+
+static void ScenePass(R_Framebuffer* output, R_Framebuffer** inputs, u32 input_count, void* user) {
+    R_CommandBufferReset(&v_solid_state_state.scene_cmds);
+    SceneRecord(&v_solid_state_state.scene_cmds);
+    R_CommandBuffersSubmit(&v_solid_state_state.scene_cmds, 1);
+}
+
+static void CompositePass(R_Framebuffer* output, R_Framebuffer** inputs, u32 input_count, void* user) {
     R_BlendDisable();
     R_DepthDisable();
     R_Clear(BufferMask_Color);
     R_PipelineBind(&v_solid_state_state.fullscreen_vertex_array);
-    R_Texture2DBindTo(&v_solid_state_state.fbo_color0, 1);
-    R_ShaderPackUploadInt(&v_solid_state_state.two_dim, str_lit("u_tex"), 1);
+    R_Texture2DBindTo(&inputs[0]->color_attachments[0], 1);
+    R_UniformUploadInt(v_solid_state_state.two_dim_tex, 1);
     R_Draw(&v_solid_state_state.fullscreen_vertex_array, 0, 6);
 }
 
+dll_export void CustomRender(void) {
+    R_FrameGraph graph;
+    R_FrameGraphBegin(&graph);
+    // Imported rather than transient, picking reads object ids back from it outside the frame
+    R_GraphTarget scene = R_FrameGraphImport(&graph, v_solid_state_state.fbo);
+    R_FrameGraphPass(&graph, str_lit("Scene"), scene, ScenePass, nullptr);
+    u32 composite = R_FrameGraphPass(&graph, str_lit("Composite"), R_FRAME_GRAPH_SCREEN, CompositePass, nullptr);
+    R_FrameGraphRead(&graph, composite, scene);
+    R_FrameGraphExecute(&graph);
+}
+
 dll_export void Render(R2D_Renderer* renderer) {
     UI_SetColorProperty(ColorProperty_Button_Base, (vec4) { 0.3f, 0.3f, 0.3f, 1.0f });
     UI_SetColorProperty(ColorProperty_Button_Hover, (vec4) { 0.2f, 0.2f, 0.2f, 1.0f });
@@ -513,36 +567,46 @@ dll_export void Update(f32 dt) {
     }
     if (OS_InputButtonReleased(Input_MouseButton_Left)) {
         if (v_solid_state_state.pressed_loc_x == x && v_solid_state_state.pressed_loc_y == y) {
-            i32 v;
-			R_FramebufferReadPixel(&v_solid_state_state.fbo, 1, (u32)x, (u32)y, &v);
-            v_solid_state_state.selected_obj_id = v;
+			R_FramebufferReadPixelAsync(&v_solid_state_state.pick_readback, v_solid_state_state.fbo, 1, (u32)x, (u32)y);
         }
     }
+    
+    // The id lands a frame or two after the click, keep frames coming until it does
+    i32 picked;
+    if (R_ReadbackPoll(&v_solid_state_state.pick_readback, &picked))
+        v_solid_state_state.selected_obj_id = picked;
+    else if (R_ReadbackIsPending(&v_solid_state_state.pick_readback))
+        F_RequestRedraw();
 }
 
 dll_export void OnResize(u32 new_w, u32 new_h) {
     data.projection = mat4_perspective(80, (f32)new_w / (f32)new_h, 1, 1000);
-    if (new_w != 0 && new_h != 0)
-        R_FramebufferResize(&v_solid_state_state.fbo, new_w, new_h);
+    if (new_w != 0 && new_h != 0) {
+        // The old size stays pooled for a while, resizing back and forth doesn't reallocate
+        R_RenderTargetRelease(v_solid_state_state.fbo);
+        R_RenderTargetDesc scene_desc = SceneTargetDesc(new_w, new_h);
+        v_solid_state_state.fbo = R_RenderTargetAcquire(&scene_desc);
+    }
     v_solid_state_state.framebuffer_width = new_w;
     v_solid_state_state.framebuffer_height = new_h;
 }
 
 dll_export void Free(void) {
     R_BufferFree(&v_solid_state_state.sphere_buffer);
+    R_BufferFree(&v_solid_state_state.sphere_instance_buffer);
     R_PipelineFree(&v_solid_state_state.sphere_vertex_array);
     R_BufferFree(&v_solid_state_state.fullscreen_buffer);
     R_PipelineFree(&v_solid_state_state.fullscreen_vertex_array);
     R_BufferFree(&v_solid_state_state.lines_buffer);
+    R_BufferFree(&v_solid_state_state.camera_buffer);
     R_PipelineFree(&v_solid_state_state.lines_vertex_array);
     
     R_ShaderPackFree(&v_solid_state_state.three_dim);
     R_ShaderPackFree(&v_solid_state_state.three_dim_lines);
     R_ShaderPackFree(&v_solid_state_state.two_dim);
-    R_FramebufferFree(&v_solid_state_state.fbo);
-    R_Texture2DFree(&v_solid_state_state.fbo_color0);
-    R_Texture2DFree(&v_solid_state_state.fbo_color1);
-    R_Texture2DFree(&v_solid_state_state.fbo_depth);
+    R_RenderTargetRelease(v_solid_state_state.fbo);
+    R_ReadbackFree(&v_solid_state_state.pick_readback);
+    R_CommandBufferFree(&v_solid_state_state.scene_cmds);
 	
 	string packed_data = {
 		.str = (u8*) &data,